@@ -0,0 +1,582 @@
+#include <algorithm>
+#include <limits>
+#include "BatchSimulation.h"
+#include "EntityKernel.h"
+
+// Rows of the hit/gone masks, one per entity slot: a kind's slots start at entityRow(kind)
+static int entityRow(int kind)
+{
+    int row = 0;
+    for (int k = 0; k < kind; k++)
+        row += ENTITY_PARAMS[k].maxCount;
+    return row;
+}
+
+static const int ENTITY_ROWS = entityRow(ENTITY_KINDS);
+
+// Unused slots sit at +infinity so the entity kernel never flags them
+const float EMPTY_SLOT_X = std::numeric_limits<float>::infinity();
+
+static void clearSlots(BatchState &batch, std::vector<float> &x, int i, int from, int to)
+{
+    for (int j = from; j < to; j++)
+        x[j * batch.count + i] = EMPTY_SLOT_X;
+}
+
+void initBatch(BatchState &batch, int count, unsigned long long seed)
+{
+    batch.count = count;
+
+    batch.backgroundX.assign(count, -WINDOW_WIDTH);
+    batch.gameSpeed.resize(count);
+    batch.gameTime.resize(count);
+    batch.gameState.resize(count);
+    batch.score.resize(count);
+    batch.lives.resize(count);
+    batch.paused.resize(count);
+    batch.playerY.resize(count);
+    batch.jumpSpeed.resize(count);
+    batch.isJumping.resize(count);
+    batch.isDucking.resize(count);
+    batch.isInvincible.resize(count);
+    batch.isDoublePoints.resize(count);
+    batch.powerup1ActiveTime.resize(count);
+    batch.powerup2ActiveTime.resize(count);
+    batch.obstacleSpawnTimer.resize(count);
+    batch.collectableSpawnTimer.resize(count);
+    batch.powerupSpawnTimer.resize(count);
+    batch.obstacleSpawnInterval.resize(count);
+    batch.collectableSpawnInterval.resize(count);
+    batch.powerupSpawnInterval.resize(count);
+    batch.collectableAngle.resize(count);
+    batch.oscillatePowerupY.resize(count);
+    batch.oscillatePowerupDY.resize(count);
+    batch.rng.resize(count);
+
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        batch.entityX[kind].assign(count * ENTITY_PARAMS[kind].maxCount, EMPTY_SLOT_X);
+        batch.entityY[kind].resize(count * ENTITY_PARAMS[kind].maxCount);
+        batch.entityCount[kind].resize(count);
+    }
+
+    batch.ticking.resize(count);
+    batch.moveSpeed.resize(count);
+    batch.moveDy.resize(count);
+    batch.hits.resize(ENTITY_ROWS * ((count + 31) / 32));
+    batch.gone.resize(ENTITY_ROWS * ((count + 31) / 32));
+    batch.touched.resize((count + 31) / 32);
+
+    for (int i = 0; i < count; i++)
+    {
+        seedRng(batch.rng[i], seed + i);
+        initBatchGame(batch, i);
+    }
+}
+
+// Same as rollbackGame() for game i
+static void rollbackBatchGame(BatchState &batch, int i)
+{
+    batch.gameSpeed[i] = INITIAL_GAME_SPEED;
+    batch.gameState[i] = 1;
+    batch.paused[i] = false;
+
+    batch.playerY[i] = PLAYER_BASE_Y;
+    batch.jumpSpeed[i] = JUMP_SPEED_INIT;
+
+    batch.isJumping[i] = false;
+    batch.isDucking[i] = false;
+    batch.isInvincible[i] = false;
+    batch.isDoublePoints[i] = false;
+
+    batch.powerup1ActiveTime[i] = POWERUP1_ACTIVE_TIME;
+    batch.powerup2ActiveTime[i] = POWERUP2_ACTIVE_TIME;
+
+    batch.obstacleSpawnTimer[i] = 0;
+    batch.collectableSpawnTimer[i] = 0;
+    batch.powerupSpawnTimer[i] = 0;
+    batch.obstacleSpawnInterval[i] = OBSTACLE_SPAWN_INTERVAL;
+    batch.collectableSpawnInterval[i] = COLLECTABLE_SPAWN_INTERVAL;
+    batch.powerupSpawnInterval[i] = POWERUP_SPAWN_INTERVAL;
+
+    batch.collectableAngle[i] = 0;
+    batch.oscillatePowerupY[i] = 0;
+    batch.oscillatePowerupDY[i] = 1;
+
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        clearSlots(batch, batch.entityX[kind], i, 0, batch.entityCount[kind][i]);
+        batch.entityCount[kind][i] = 0;
+    }
+}
+
+void initBatchGame(BatchState &batch, int i)
+{
+    batch.gameTime[i] = GAME_DURATION;
+    batch.lives[i] = INITIAL_LIVES;
+    batch.score[i] = 0;
+    rollbackBatchGame(batch, i);
+    batch.gameState[i] = 0;
+}
+
+// Same as the key handling in step() for game i
+static void applyBatchInput(BatchState &batch, int i, unsigned char keys)
+{
+    bool grounded = batch.playerY[i] <= PLAYER_BASE_Y;
+
+    if (keys & INPUT_RESTART)
+    {
+        initBatchGame(batch, i);
+        batch.gameState[i] = 1;
+        grounded = true;
+    }
+    if ((keys & INPUT_START) && batch.gameState[i] == 0)
+        batch.gameState[i] = 1;
+    if ((keys & INPUT_DUCK) && grounded && !batch.isJumping[i] && !batch.isDucking[i])
+        batch.isDucking[i] = true;
+    if ((keys & INPUT_JUMP) && grounded && !batch.isJumping[i] && !batch.isDucking[i])
+        batch.isJumping[i] = true;
+    if (keys & INPUT_PAUSE)
+        batch.paused[i] = !batch.paused[i];
+    if (keys & INPUT_DUCK_UP)
+        batch.isDucking[i] = false;
+}
+
+static int maskWords(const BatchState &batch)
+{
+    return (batch.count + 31) / 32;
+}
+
+static bool maskBit(const BatchState &batch, const std::vector<unsigned int> &mask, int row, int i)
+{
+    return (mask[row * maskWords(batch) + (unsigned int)i / 32] >> ((unsigned int)i % 32)) & 1;
+}
+
+// Runs the entity kernel over the first `slots` slots of one kind for games [begin, end)
+static void advanceSlots(BatchState &batch, int kind, int slots, int begin, int end)
+{
+    const EntityParams &params = ENTITY_PARAMS[kind];
+    std::vector<float> &x = batch.entityX[kind];
+    std::vector<float> &y = batch.entityY[kind];
+    int row = entityRow(kind);
+    int words = maskWords(batch);
+    for (int j = 0; j < slots; j++)
+    {
+        unsigned int *hits = &batch.hits[(row + j) * words + begin / 32];
+        unsigned int *gone = &batch.gone[(row + j) * words + begin / 32];
+        for (int w = 0; w < (end - begin + 31) / 32; w++)
+        {
+            hits[w] = 0;
+            gone[w] = 0;
+        }
+
+        advanceEntities(&x[j * batch.count + begin], &y[j * batch.count + begin], end - begin, params.speed,
+                        &batch.moveSpeed[begin], params.oscillates ? &batch.moveDy[begin] : nullptr,
+                        &batch.playerY[begin], PLAYER_SIZE / 2 + params.size / 2, -params.size, hits, gone);
+
+        unsigned int *touched = &batch.touched[begin / 32];
+        for (int w = 0; w < (end - begin + 31) / 32; w++)
+            touched[w] |= hits[w] | gone[w];
+    }
+}
+
+// Same as applyHit() in step() for game i
+static bool applyBatchHit(BatchState &batch, int i, EntityEffect effect)
+{
+    switch (effect)
+    {
+    case EFFECT_DAMAGE:
+        batch.lives[i]--;
+        if (batch.lives[i] <= 0)
+        {
+            batch.gameState[i] = 2;
+            return true;
+        }
+        rollbackBatchGame(batch, i);
+        return false;
+    case EFFECT_SCORE:
+        batch.score[i] += batch.isDoublePoints[i] ? 20 : 10;
+        return true;
+    case EFFECT_INVINCIBILITY:
+        batch.isInvincible[i] = true;
+        batch.powerup1ActiveTime[i] = POWERUP1_ACTIVE_TIME;
+        return true;
+    case EFFECT_DOUBLE_POINTS:
+        batch.isDoublePoints[i] = true;
+        batch.powerup2ActiveTime[i] = POWERUP2_ACTIVE_TIME;
+        return true;
+    }
+    return true;
+}
+
+// Applies the hits of game i's entities of one kind and drops those that hit the player or
+// left the screen, keeping the rest in order. Returns false if the game rolled back.
+static bool compactSlots(BatchState &batch, int kind, int i)
+{
+    const EntityParams &params = ENTITY_PARAMS[kind];
+    std::vector<float> &x = batch.entityX[kind];
+    std::vector<float> &y = batch.entityY[kind];
+    int &count = batch.entityCount[kind][i];
+    int row = entityRow(kind);
+    int n = batch.count;
+
+    int kept = 0;
+    for (int j = 0; j < count; j++)
+    {
+        bool harmless = params.effect == EFFECT_DAMAGE && batch.isInvincible[i];
+        bool hit = !harmless && maskBit(batch, batch.hits, row + j, i);
+        if (hit && !applyBatchHit(batch, i, params.effect))
+            return false;
+
+        if (kept != j)
+        {
+            x[kept * n + i] = x[j * n + i];
+            y[kept * n + i] = y[j * n + i];
+        }
+        kept += !hit && !maskBit(batch, batch.gone, row + j, i);
+    }
+    clearSlots(batch, x, i, kept, count);
+    count = kept;
+    return true;
+}
+
+void stepBatch(BatchState &batch, const GameInput *inputs)
+{
+    stepBatch(batch, inputs, 0, batch.count);
+}
+
+void stepBatch(BatchState &batch, const GameInput *inputs, int begin, int end)
+{
+    // Input, timers and player physics, one field array at a time
+    for (int i = begin; i < end; i++)
+    {
+        if (inputs[i].keys)
+            applyBatchInput(batch, i, inputs[i].keys);
+
+        batch.backgroundX[i] += 1;
+        if (batch.backgroundX[i] >= WINDOW_WIDTH)
+            batch.backgroundX[i] = -WINDOW_WIDTH;
+
+        batch.ticking[i] = batch.gameState[i] == 1 && !batch.paused[i];
+    }
+
+    for (int i = begin; i < end; i++)
+    {
+        if (!batch.ticking[i])
+            continue;
+
+        batch.gameTime[i] -= 1.0 / FPS;
+        batch.obstacleSpawnTimer[i] -= 1.0 / FPS;
+        batch.collectableSpawnTimer[i] -= 1.0 / FPS;
+        batch.powerupSpawnTimer[i] -= 1.0 / FPS;
+
+        batch.collectableAngle[i] += 5.0f;
+        batch.oscillatePowerupY[i] += batch.oscillatePowerupDY[i] * 0.5;
+        if (batch.oscillatePowerupY[i] > 2 || batch.oscillatePowerupY[i] < -2)
+            batch.oscillatePowerupDY[i] *= -1;
+
+        if (batch.isInvincible[i])
+            batch.powerup1ActiveTime[i] -= 1.0 / FPS;
+        if (batch.isDoublePoints[i])
+            batch.powerup2ActiveTime[i] -= 1.0 / FPS;
+
+        if (batch.powerup1ActiveTime[i] <= 0)
+        {
+            batch.isInvincible[i] = false;
+            batch.powerup1ActiveTime[i] = POWERUP1_ACTIVE_TIME;
+        }
+        if (batch.powerup2ActiveTime[i] <= 0)
+        {
+            batch.isDoublePoints[i] = false;
+            batch.powerup2ActiveTime[i] = POWERUP2_ACTIVE_TIME;
+        }
+
+        if (batch.gameTime[i] <= 0)
+            batch.gameState[i] = 2;
+
+        batch.gameSpeed[i] += GAME_SPEED_INCREASE;
+        batch.jumpSpeed[i] += GAME_SPEED_INCREASE;
+        batch.obstacleSpawnInterval[i] = OBSTACLE_SPAWN_INTERVAL / batch.gameSpeed[i];
+        batch.collectableSpawnInterval[i] = COLLECTABLE_SPAWN_INTERVAL / batch.gameSpeed[i];
+        batch.powerupSpawnInterval[i] = POWERUP_SPAWN_INTERVAL / batch.gameSpeed[i];
+
+        float playerY = batch.playerY[i];
+        if (batch.isJumping[i])
+        {
+            playerY += batch.jumpSpeed[i];
+            if (playerY >= PLAYER_BASE_Y + JUMP_HEIGHT)
+                batch.isJumping[i] = false;
+        }
+        else if (playerY > PLAYER_BASE_Y && !batch.isDucking[i])
+        {
+            playerY -= batch.jumpSpeed[i];
+        }
+
+        if (batch.isDucking[i])
+            playerY = PLAYER_BASE_Y - DUCK_HEIGHT;
+        else if (!batch.isJumping[i] && playerY < PLAYER_BASE_Y)
+            playerY = PLAYER_BASE_Y;
+        batch.playerY[i] = playerY;
+    }
+
+    // Entity movement and overlap tests for every game at once, one slot at a time.
+    // Games that do not tick get a zero speed so their entities stay put.
+    int maxSlots[ENTITY_KINDS] = {};
+    for (int i = begin; i < end; i++)
+    {
+        batch.moveSpeed[i] = batch.ticking[i] ? batch.gameSpeed[i] : 0;
+        batch.moveDy[i] = batch.ticking[i] ? batch.oscillatePowerupY[i] : 0;
+        for (int kind = 0; kind < ENTITY_KINDS; kind++)
+            maxSlots[kind] = std::max(maxSlots[kind], batch.entityCount[kind][i]);
+    }
+
+    for (int w = begin / 32; w < (end + 31) / 32; w++)
+        batch.touched[w] = 0;
+
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+        advanceSlots(batch, kind, maxSlots[kind], begin, end);
+
+    // Collision effects, compaction and spawning, one game at a time.
+    // Spawn limits still see the pre-compaction sizes like the pools in step() do.
+    int n = batch.count;
+    for (int i = begin; i < end; i++)
+    {
+        if (!batch.ticking[i])
+            continue;
+
+        int sizes[ENTITY_KINDS];
+        for (int kind = 0; kind < ENTITY_KINDS; kind++)
+            sizes[kind] = batch.entityCount[kind][i];
+
+        // Only games with an entity that hit the player or left the screen need collision work
+        if (maskBit(batch, batch.touched, 0, i))
+        {
+            for (int kind = 0; kind < ENTITY_KINDS; kind++)
+            {
+                if (!compactSlots(batch, kind, i))
+                {
+                    // Rollback cleared every kind
+                    for (int k = 0; k < ENTITY_KINDS; k++)
+                        sizes[k] = 0;
+                    break;
+                }
+            }
+        }
+
+        // Spawn new objects
+        GameRng &rng = batch.rng[i];
+        if (batch.obstacleSpawnTimer[i] <= 0 && sizes[ENTITY_OBSTACLE] < MAX_OBSTACLES && nextRandom(rng) % 100 < OBSTACLE_SPAWN_PROB)
+        {
+            int slot = batch.entityCount[ENTITY_OBSTACLE][i]++;
+            batch.entityX[ENTITY_OBSTACLE][slot * n + i] = WINDOW_WIDTH;
+            batch.entityY[ENTITY_OBSTACLE][slot * n + i] = (PLAYER_BASE_Y + PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 2) - (nextRandom(rng) % 2) * DUCK_HEIGHT;
+            batch.obstacleSpawnTimer[i] = batch.obstacleSpawnInterval[i];
+        }
+
+        if (batch.collectableSpawnTimer[i] <= 0 && sizes[ENTITY_COLLECTABLE] < MAX_COLLECTABLES && nextRandom(rng) % 100 < COLLECTABLE_SPAWN_PROB)
+        {
+            int slot = batch.entityCount[ENTITY_COLLECTABLE][i]++;
+            batch.entityX[ENTITY_COLLECTABLE][slot * n + i] = WINDOW_WIDTH;
+            batch.entityY[ENTITY_COLLECTABLE][slot * n + i] = PLAYER_BASE_Y + (nextRandom(rng) % int(JUMP_HEIGHT - PLAYER_HEAD_SIZE / 2));
+            batch.collectableSpawnTimer[i] = batch.collectableSpawnInterval[i];
+        }
+
+        bool isTypeOne = nextRandom(rng) % 2;
+        if (batch.powerupSpawnTimer[i] <= 0 && sizes[ENTITY_POWERUP1] + sizes[ENTITY_POWERUP2] < MAX_POWERUPS && nextRandom(rng) % 100 < POWERUP_SPAWN_PROB)
+        {
+            int kind = isTypeOne ? ENTITY_POWERUP1 : ENTITY_POWERUP2;
+            int slot = batch.entityCount[kind][i]++;
+            batch.entityX[kind][slot * n + i] = WINDOW_WIDTH;
+            batch.entityY[kind][slot * n + i] = PLAYER_BASE_Y + (nextRandom(rng) % int(JUMP_HEIGHT - PLAYER_HEAD_SIZE / 2));
+            batch.powerupSpawnTimer[i] = batch.powerupSpawnInterval[i];
+        }
+    }
+}
+
+BatchWorkers::BatchWorkers(int threads)
+{
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    try
+    {
+        for (int t = 1; t < threads; t++)
+            helpers.emplace_back(&BatchWorkers::work, this, t);
+    }
+    catch (...)
+    {
+        // No destructor runs for a half-built object, and a joinable thread must not be destroyed
+        stop();
+        throw;
+    }
+}
+
+BatchWorkers::~BatchWorkers()
+{
+    stop();
+}
+
+void BatchWorkers::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &helper : helpers)
+        helper.join();
+}
+
+// Start of share `index` of `shares` over `count` games, rounded down to a multiple of 32
+static int shareBegin(int count, int shares, int index)
+{
+    if (index == shares)
+        return count;
+    return (int)((long long)count * index / shares) / 32 * 32;
+}
+
+void BatchWorkers::work(int index)
+{
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;)
+    {
+        wake.wait(guard, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        seen = generation;
+        if (index >= shares)
+            continue;
+        int begin = shareBegin(count, shares, index);
+        int end = shareBegin(count, shares, index + 1);
+        guard.unlock();
+        // An empty share would still clear the mask word its neighbour is using
+        if (begin < end)
+            task(context, begin, end);
+        guard.lock();
+        if (--pending == 0)
+            done.notify_one();
+    }
+}
+
+void BatchWorkers::run(int games, Task job, void *data)
+{
+    // No share smaller than one mask word
+    int used = std::max(1, std::min((int)helpers.size() + 1, (games + 31) / 32));
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        task = job;
+        context = data;
+        count = games;
+        shares = used;
+        pending = used - 1;
+        generation++;
+    }
+    if (used > 1)
+        wake.notify_all();
+    int end = shareBegin(games, used, 1);
+    if (end > 0)
+        job(data, 0, end);
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [&] { return pending == 0; });
+}
+
+struct StepJob
+{
+    BatchState *batch;
+    const GameInput *inputs;
+};
+
+static void stepShare(void *context, int begin, int end)
+{
+    StepJob &job = *(StepJob *)context;
+    stepBatch(*job.batch, job.inputs, begin, end);
+}
+
+void stepBatch(BatchState &batch, const GameInput *inputs, BatchWorkers &workers)
+{
+    StepJob job = {&batch, inputs};
+    workers.run(batch.count, stepShare, &job);
+}
+
+void loadBatchGame(const BatchState &batch, int i, GameState &state)
+{
+    state.backgroundX = batch.backgroundX[i];
+    state.gameSpeed = batch.gameSpeed[i];
+    state.gameTime = batch.gameTime[i];
+    state.gameState = batch.gameState[i];
+    state.score = batch.score[i];
+    state.lives = batch.lives[i];
+    state.paused = batch.paused[i];
+    state.playerY = batch.playerY[i];
+    state.jumpSpeed = batch.jumpSpeed[i];
+    state.isJumping = batch.isJumping[i];
+    state.isDucking = batch.isDucking[i];
+    state.isInvincible = batch.isInvincible[i];
+    state.isDoublePoints = batch.isDoublePoints[i];
+    state.powerup1ActiveTime = batch.powerup1ActiveTime[i];
+    state.powerup2ActiveTime = batch.powerup2ActiveTime[i];
+    state.obstacleSpawnTimer = batch.obstacleSpawnTimer[i];
+    state.collectableSpawnTimer = batch.collectableSpawnTimer[i];
+    state.powerupSpawnTimer = batch.powerupSpawnTimer[i];
+    state.obstacleSpawnInterval = batch.obstacleSpawnInterval[i];
+    state.collectableSpawnInterval = batch.collectableSpawnInterval[i];
+    state.powerupSpawnInterval = batch.powerupSpawnInterval[i];
+    state.collectableAngle = batch.collectableAngle[i];
+    state.oscillatePowerupY = batch.oscillatePowerupY[i];
+    state.oscillatePowerupDY = batch.oscillatePowerupDY[i];
+    state.rng = batch.rng[i];
+
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        state.entities[kind].clear();
+        for (int j = 0; j < batch.entityCount[kind][i]; j++)
+            state.entities[kind].push({batch.entityX[kind][j * batch.count + i], batch.entityY[kind][j * batch.count + i], true});
+    }
+}
+
+void storeBatchGame(BatchState &batch, int i, const GameState &state)
+{
+    batch.backgroundX[i] = state.backgroundX;
+    batch.gameSpeed[i] = state.gameSpeed;
+    batch.gameTime[i] = state.gameTime;
+    batch.gameState[i] = state.gameState;
+    batch.score[i] = state.score;
+    batch.lives[i] = state.lives;
+    batch.paused[i] = state.paused;
+    batch.playerY[i] = state.playerY;
+    batch.jumpSpeed[i] = state.jumpSpeed;
+    batch.isJumping[i] = state.isJumping;
+    batch.isDucking[i] = state.isDucking;
+    batch.isInvincible[i] = state.isInvincible;
+    batch.isDoublePoints[i] = state.isDoublePoints;
+    batch.powerup1ActiveTime[i] = state.powerup1ActiveTime;
+    batch.powerup2ActiveTime[i] = state.powerup2ActiveTime;
+    batch.obstacleSpawnTimer[i] = state.obstacleSpawnTimer;
+    batch.collectableSpawnTimer[i] = state.collectableSpawnTimer;
+    batch.powerupSpawnTimer[i] = state.powerupSpawnTimer;
+    batch.obstacleSpawnInterval[i] = state.obstacleSpawnInterval;
+    batch.collectableSpawnInterval[i] = state.collectableSpawnInterval;
+    batch.powerupSpawnInterval[i] = state.powerupSpawnInterval;
+    batch.collectableAngle[i] = state.collectableAngle;
+    batch.oscillatePowerupY[i] = state.oscillatePowerupY;
+    batch.oscillatePowerupDY[i] = state.oscillatePowerupDY;
+    batch.rng[i] = state.rng;
+
+    // Inactive objects are dropped at the end of every step, so only active ones are kept
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        int slots = ENTITY_PARAMS[kind].maxCount;
+        int count = 0;
+        for (auto &entity : state.entities[kind])
+        {
+            if (entity.active && count < slots)
+            {
+                batch.entityX[kind][count * batch.count + i] = entity.x;
+                batch.entityY[kind][count * batch.count + i] = entity.y;
+                count++;
+            }
+        }
+        clearSlots(batch, batch.entityX[kind], i, count, slots);
+        batch.entityCount[kind][i] = count;
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Simulation.h"
+
+// Many independent games laid out as structure-of-arrays, one element per game.
+// Entity lists use a fixed number of slots per game, kept compacted and in spawn order.
+struct BatchState
+{
+    int count;
+
+    std::vector<int> backgroundX;
+    std::vector<float> gameSpeed;
+    std::vector<float> gameTime;
+    std::vector<int> gameState;
+    std::vector<int> score;
+    std::vector<int> lives;
+    std::vector<unsigned char> paused;
+    std::vector<float> playerY;
+    std::vector<float> jumpSpeed;
+    std::vector<unsigned char> isJumping;
+    std::vector<unsigned char> isDucking;
+    std::vector<unsigned char> isInvincible;
+    std::vector<unsigned char> isDoublePoints;
+    std::vector<float> powerup1ActiveTime;
+    std::vector<float> powerup2ActiveTime;
+    std::vector<float> obstacleSpawnTimer;
+    std::vector<float> collectableSpawnTimer;
+    std::vector<float> powerupSpawnTimer;
+    std::vector<float> obstacleSpawnInterval;
+    std::vector<float> collectableSpawnInterval;
+    std::vector<float> powerupSpawnInterval;
+    std::vector<float> collectableAngle;
+    std::vector<float> oscillatePowerupY;
+    std::vector<float> oscillatePowerupDY;
+    std::vector<GameRng> rng;
+
+    // Indexed by EntityKind. Element [slot * count + game] holds a game's entity in that slot,
+    // so one slot of every game is contiguous for the entity kernel
+    std::vector<float> entityX[ENTITY_KINDS];
+    std::vector<float> entityY[ENTITY_KINDS];
+    std::vector<int> entityCount[ENTITY_KINDS];
+
+    // Scratch for the current step: games that advance, their entity speeds and
+    // powerup oscillation, per-slot hit/off-screen bitmasks over games, and
+    // the games with any bit set in those masks
+    std::vector<unsigned char> ticking;
+    std::vector<float> moveSpeed;
+    std::vector<float> moveDy;
+    std::vector<unsigned int> hits;
+    std::vector<unsigned int> gone;
+    std::vector<unsigned int> touched;
+};
+
+// Game i draws its spawns from seed + i, like a GameState started with initGame(state, seed + i)
+void initBatch(BatchState &, int, unsigned long long);
+// Same as restarting game i with 'r': its random stream carries on
+void initBatchGame(BatchState &, int);
+void stepBatch(BatchState &, const GameInput *);
+// Steps games [begin, end) only; ranges stepped at the same time must start at multiples of 32
+void stepBatch(BatchState &, const GameInput *, int, int);
+
+// Threads that stay alive from one batch step to the next, so stepping thousands of games on every
+// core does not start threads every tick. run() splits games [0, count) into one share per thread,
+// each starting at a multiple of 32 as stepBatch() ranges must, and returns once all are done.
+struct BatchWorkers
+{
+    typedef void (*Task)(void *context, int begin, int end);
+
+    explicit BatchWorkers(int threads); // 0: one per core
+    ~BatchWorkers();
+    void run(int count, Task task, void *context);
+
+    std::mutex lock;
+    std::condition_variable wake, done;
+    std::vector<std::thread> helpers;
+    unsigned long long generation = 0; // bumped for every run()
+    int pending = 0;                   // helpers still on the current run
+    bool stopping = false;
+
+    // The current run
+    Task task = nullptr;
+    void *context = nullptr;
+    int count = 0, shares = 1;
+
+    void work(int index);
+    void stop();
+};
+
+// Steps every game, the shares spread over `workers`; results do not depend on the thread count
+void stepBatch(BatchState &, const GameInput *, BatchWorkers &);
+
+// Copies one game between the batch and a standalone GameState
+void loadBatchGame(const BatchState &, int, GameState &);
+void storeBatchGame(BatchState &, int, const GameState &);
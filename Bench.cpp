@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <glut.h>
+#include "Draw.h"
+#include "Parallax.h"
+#include "PixelRenderer.h"
+#include "Renderer.h"
+#include "Simulation.h"
+#include "Text.h"
+
+// Microbenchmarks for step(), the draw functions and the render backends, written out as JSON so releases
+// can be compared.
+// Usage: Bench [output.json] (stdout when no file is given)
+//        Bench --check-software
+// --check-software only compares the two CPU rasterizers and exits with 1 if they disagree.
+// Drawing goes to a hidden GLUT window. The renderer string is part of the output: numbers from a
+// software context and from a GPU driver are not comparable, so compare runs on the same renderer.
+
+GameState game;
+
+// Every measurement repeats until it has run at least this long, or MAX_CALLS times.
+// The cap matters for cheap draws: a driver that queues every call until glFinish can stall on millions.
+const double MIN_SECONDS = 0.2;
+const long long MAX_CALLS = 1 << 16;
+
+// Update runs restart from the filled snapshot this often, before anything drifts off screen
+const int BLOCK_TICKS = 30;
+
+// Entities of each kind for the update runs, capped by each kind's maxCount
+const int DENSITIES[] = {0, 1, 2, 5, MAX_KIND_COUNT};
+
+struct DrawCase
+{
+    const char *name;
+    void (*draw)();
+};
+
+static void benchPlayer() { drawPlayer(); }
+static void benchObstacle() { drawObstacle(WINDOW_WIDTH / 2, PLAYER_BASE_Y); }
+static void benchCollectable() { drawCollectable(WINDOW_WIDTH / 2, PLAYER_BASE_Y); }
+static void benchPowerup() { drawPowerup(WINDOW_WIDTH / 2, PLAYER_BASE_Y, true); }
+static void benchBackground() { drawBackground(); }
+static void benchHeart() { drawHeart(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2); }
+static void benchHealth() { drawHealth(); }
+static void benchText() { drawText(WINDOW_WIDTH - 111, WINDOW_HEIGHT - 22, "Score: 1234"); }
+static void benchHudText()
+{
+    drawScore();
+    drawTime();
+    drawPowerupsState();
+}
+static void benchBoundaries() { drawBoundaries(); }
+static void benchFrame() { drawFrame(); }
+
+// Far more entities than the game's caps allow, as a stress mode would have
+const int STRESS_INSTANCES = 10000;
+static std::vector<MeshInstance> stressInstances;
+
+static void benchEntities() { drawEntities(); }
+static void benchStress()
+{
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+        drawEntityInstances(kind, stressInstances.data(), (int)stressInstances.size());
+}
+
+const DrawCase DRAW_CASES[] = {
+    {"drawPlayer", benchPlayer},   {"drawObstacle", benchObstacle}, {"drawCollectable", benchCollectable},
+    {"drawPowerup", benchPowerup}, {"drawHeart", benchHeart},       {"drawHealth", benchHealth},
+    {"drawText", benchText},       {"drawBoundaries", benchBoundaries}, {"drawFrame", benchFrame},
+    {"drawBackground", benchBackground}, {"drawHudText", benchHudText},
+    {"drawEntities", benchEntities}, {"drawEntityInstances10000", benchStress},
+};
+
+// One busy frame's shapes, recorded once and handed to every backend, so they are timed on identical work.
+// Entities go through drawEntity(), so they are commands too rather than instanced draws.
+static std::vector<DrawCommand> workload, sorted;
+static RenderBackend benchedBackend;
+static std::vector<unsigned char> softwareImage(WINDOW_WIDTH * WINDOW_HEIGHT * 3);
+
+static void recordWorkload()
+{
+    drawPlayer();
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        for (auto &entity : game.entities[kind])
+            drawEntity(kind, entity.x, entity.y);
+    }
+    drawBoundaries();
+    drawHealth();
+    takeCommands(workload);
+}
+
+// Sorting is part of every flush, so it is part of the time
+static void benchBackend()
+{
+    sorted = workload;
+    sortCommands(sorted);
+    executeCommands(benchedBackend, sorted);
+}
+
+// Times glColor would be called for the commands in this order
+static int colorChanges(const std::vector<DrawCommand> &commands)
+{
+    int changes = 0;
+    for (size_t i = 0; i < commands.size(); i++)
+    {
+        const DrawCommand &c = commands[i];
+        if (i == 0 || c.r != commands[i - 1].r || c.g != commands[i - 1].g || c.b != commands[i - 1].b)
+            changes++;
+    }
+    return changes;
+}
+
+// A started game holding `perKind` entities of each kind between mid-screen and the right edge.
+// Invincible, so nothing it meets rolls it back.
+static int fillGame(GameState &state, int perKind)
+{
+    initGame(state, 1);
+    step(state, GameInput{INPUT_START});
+    state.isInvincible = true;
+
+    int total = 0;
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        state.entities[kind].clear();
+        int n = std::min(perKind, ENTITY_PARAMS[kind].maxCount);
+        for (int j = 0; j < n; j++)
+        {
+            GameObject entity;
+            entity.x = WINDOW_WIDTH / 2 + float(WINDOW_WIDTH / 2) * j / n;
+            entity.y = PLAYER_BASE_Y + PLAYER_SIZE;
+            entity.active = true;
+            state.entities[kind].push(entity);
+        }
+        total += n;
+    }
+    return total;
+}
+
+static double ticksPerSecond(const GameState &filled)
+{
+    GameSnapshot snapshot;
+    GameState state;
+    saveSnapshot(filled, snapshot);
+
+    long long ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    double seconds = 0;
+    while (seconds < MIN_SECONDS)
+    {
+        for (int block = 0; block < 1000; block++)
+        {
+            restoreSnapshot(state, snapshot);
+            for (int t = 0; t < BLOCK_TICKS; t++)
+                step(state, GameInput{0});
+        }
+        ticks += 1000 * BLOCK_TICKS;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return ticks / seconds;
+}
+
+// Doubles the call count until one batch of calls, finished by the GL, takes MIN_SECONDS or reaches MAX_CALLS.
+// One untimed call first keeps the driver's first-use work (state compiles and the like) out of the numbers.
+// Each call is flushed, so its batched shapes and text are drawn and counted, and nothing grows between calls.
+static double nsPerCall(void (*draw)())
+{
+    draw();
+    flushText();
+    glFinish();
+    for (long long calls = 1;; calls *= 2)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (long long i = 0; i < calls; i++)
+        {
+            draw();
+            flushText();
+        }
+        glFinish();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds >= MIN_SECONDS || calls >= MAX_CALLS)
+            return seconds * 1e9 / calls;
+    }
+}
+
+static std::string jsonString(const char *text)
+{
+    std::string out = "\"";
+    for (const char *c = text; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            out += '\\';
+        if ((unsigned char)*c >= ' ')
+            out += *c;
+    }
+    return out + "\"";
+}
+
+// PixelRenderer keeps its own copy of the scene rather than replaying draw commands: it runs on many
+// threads at once and in builds without GL, and the command recorder is one global stream in a file
+// that needs GL. This check keeps the copies from drifting. Sampling at pixel centers is shared, but
+// circles (true circles against 50-sided polygons) and edge rules differ, so a frame may differ in
+// this many pixels. A missing center dot (25 pixels) or power-up line (20) takes it over.
+const int MAX_DIFFERING_PIXELS = 32;
+
+// Frames of a played game, drawn by the draw functions through BACKEND_SOFTWARE and by renderGame().
+// Neither draws hearts or text. Returns false if any frame differs in more than MAX_DIFFERING_PIXELS.
+static bool checkSoftwareRasterizers()
+{
+    const int pixels = WINDOW_WIDTH * WINDOW_HEIGHT;
+    std::vector<unsigned char> commands(pixels * 3), direct(pixels * 3);
+    RenderBackend previous = renderBackend();
+    setRenderBackend(BACKEND_SOFTWARE);
+    setSoftwareTarget(commands.data(), WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    // Jumping often with invincibility keeps the game going and the player off the ground
+    initGame(game, 1);
+    bool agree = true;
+    for (int tick = 0; tick < 3000; tick++)
+    {
+        game.isInvincible = true;
+        step(game, GameInput{(unsigned char)(tick == 0 ? INPUT_START : tick % 40 == 0 ? INPUT_JUMP : 0)});
+        if (tick % 100 != 99)
+            continue;
+
+        // The sky is the GL clear color, which the software target does not see
+        for (int p = 0; p < pixels; p++)
+        {
+            commands[3 * p] = 0;
+            commands[3 * p + 1] = (unsigned char)(0.1f * 255 + 0.5f);
+            commands[3 * p + 2] = (unsigned char)(0.9f * 255 + 0.5f);
+        }
+        drawBackground();
+        drawPlayer();
+        for (int kind = 0; kind < ENTITY_KINDS; kind++)
+        {
+            for (auto &entity : game.entities[kind])
+                drawEntity(kind, entity.x, entity.y);
+        }
+        drawBoundaries();
+        flushBatch();
+        renderGame(game, direct.data(), WINDOW_WIDTH, WINDOW_HEIGHT, PIXELS_RGB);
+
+        // One unit of color rounding is not a difference
+        int differing = 0;
+        for (int p = 0; p < pixels; p++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                if (std::abs(commands[3 * p + c] - direct[3 * p + c]) > 1)
+                {
+                    differing++;
+                    break;
+                }
+            }
+        }
+        printf("tick %d: %d pixels differ\n", tick, differing);
+        if (differing > MAX_DIFFERING_PIXELS)
+            agree = false;
+    }
+
+    setSoftwareTarget(nullptr, 0, 0);
+    setRenderBackend(previous);
+    printf("%s\n", agree ? "OK" : "MISMATCH");
+    return agree;
+}
+
+int main(int argc, char **argv)
+{
+    glutInit(&argc, argv);
+    glutInitDisplayMode(GLUT_SINGLE | GLUT_RGB);
+    glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
+    glutCreateWindow("bench");
+    glutHideWindow();
+    gluOrtho2D(0, WINDOW_WIDTH, 0, WINDOW_HEIGHT);
+    initRenderer();
+    if (argc > 1 && strcmp(argv[1], "--check-software") == 0)
+        return checkSoftwareRasterizers() ? 0 : 1;
+    initText();
+    initParallax(DAWN_LAYERS_DIRECTORY, DAWN_LAYERS);
+
+    FILE *out = argc > 1 ? fopen(argv[1], "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "could not write %s\n", argv[1]);
+        return 2;
+    }
+
+    const char *renderer = (const char *)glGetString(GL_RENDERER);
+    fprintf(out, "{\n  \"renderer\": %s,\n", jsonString(renderer ? renderer : "").c_str());
+
+    fprintf(out, "  \"update\": [\n");
+    int densities = sizeof(DENSITIES) / sizeof(DENSITIES[0]);
+    for (int d = 0; d < densities; d++)
+    {
+        GameState filled;
+        int entities = fillGame(filled, DENSITIES[d]);
+        fprintf(out, "    {\"entities\": %d, \"ticksPerSecond\": %.0f}%s\n", entities, ticksPerSecond(filled),
+                d + 1 < densities ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+
+    // The draw functions see a busy game in play, as in the middle of a run
+    fillGame(game, MAX_KIND_COUNT);
+    game.lives = INITIAL_LIVES;
+    for (int i = 0; i < STRESS_INSTANCES; i++)
+    {
+        float x = float(i * 37 % WINDOW_WIDTH);
+        float y = float(i * 53 % WINDOW_HEIGHT);
+        stressInstances.push_back({x, y, float(i % 360)});
+    }
+
+    fprintf(out, "  \"draw\": [\n");
+    int cases = sizeof(DRAW_CASES) / sizeof(DRAW_CASES[0]);
+    for (int c = 0; c < cases; c++)
+    {
+        fprintf(out, "    {\"name\": \"%s\", \"nsPerCall\": %.1f}%s\n", DRAW_CASES[c].name,
+                nsPerCall(DRAW_CASES[c].draw), c + 1 < cases ? "," : "");
+    }
+    fprintf(out, "  ],\n");
+
+    recordWorkload();
+    sorted = workload;
+    sortCommands(sorted);
+    setSoftwareTarget(softwareImage.data(), WINDOW_WIDTH, WINDOW_HEIGHT);
+    fprintf(out, "  \"backends\": {\n");
+    fprintf(out, "    \"commands\": %d, \"colorChanges\": %d, \"sortedColorChanges\": %d,\n", (int)workload.size(),
+            colorChanges(workload), colorChanges(sorted));
+    fprintf(out, "    \"runs\": [\n");
+    for (int b = 0; b < RENDER_BACKENDS; b++)
+    {
+        benchedBackend = (RenderBackend)b;
+        fprintf(out, "      {\"name\": \"%s\", \"nsPerCall\": %.1f}%s\n", backendName(benchedBackend),
+                nsPerCall(benchBackend), b + 1 < RENDER_BACKENDS ? "," : "");
+    }
+    fprintf(out, "    ]\n  }\n}\n");
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
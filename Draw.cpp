@@ -0,0 +1,658 @@
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <glut.h>
+#include "Draw.h"
+#include "Parallax.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Text.h"
+
+// An entity kind's layers: its base, the shape over it, and the center over both
+const int ENTITY_PARTS = 3;
+
+// Draw order within a flush, back to front. Shapes in one layer may be drawn in any order,
+// so each part that covers another gets a layer of its own.
+enum DrawLayer
+{
+    LAYER_SUN,
+    LAYER_CLOUDS,
+    LAYER_PLAYER_BODY,
+    LAYER_PLAYER_HEAD,
+    LAYER_PLAYER_FACE,
+    LAYER_ENTITIES,
+    LAYER_BOUNDARIES = LAYER_ENTITIES + ENTITY_KINDS * ENTITY_PARTS,
+    LAYER_BOUNDARY_DETAILS,
+    LAYER_HEARTS,
+    LAYER_HEART_LINES
+};
+
+static void entityLayer(int kind, int part)
+{
+    batchLayer(LAYER_ENTITIES + kind * ENTITY_PARTS + part);
+}
+
+// Shapes tessellated once at startup; the draw functions only place and color them
+struct DrawMeshes
+{
+    int circle;   // radius 1, as many sides as the gluDisk it replaced
+    int shuriken; // radius 1
+    int heart;
+    int playerBody;
+    int playerHead;
+    int playerEyes;
+    int playerMouth;
+};
+
+static DrawMeshes buildMeshes()
+{
+    Mesh circle, shuriken, heart, playerBody, playerHead, playerEyes, playerMouth;
+
+    const int CIRCLE_SIDES = 50;
+    float points[2 * CIRCLE_SIDES];
+    for (int i = 0; i < CIRCLE_SIDES; i++)
+    {
+        float theta = 2.0f * 3.14159265f * i / CIRCLE_SIDES;
+        points[2 * i] = sinf(theta);
+        points[2 * i + 1] = cosf(theta);
+    }
+    meshPolygon(circle, points, CIRCLE_SIDES);
+
+    // Upper, lower, right and left triangles
+    meshTriangle(shuriken, 0, 1, -0.5f, 0, 0.5f, 0);
+    meshTriangle(shuriken, 0, -1, -0.5f, 0, 0.5f, 0);
+    meshTriangle(shuriken, 1, 0, 0, -0.5f, 0, 0.5f);
+    meshTriangle(shuriken, -1, 0, 0, -0.5f, 0, 0.5f);
+
+    float outline[2 * 360];
+    for (int j = 0; j < 360; j++)
+    {
+        float theta = j * 3.14f / 180.0f;
+        outline[2 * j] = 16 * pow(sin(theta), 3);
+        outline[2 * j + 1] = 13 * cos(theta) - 5 * cos(2 * theta) - 2 * cos(3 * theta) - cos(4 * theta);
+    }
+    meshPolygon(heart, outline, 360);
+
+    // Body (Hexagon)
+    float body[2 * 6];
+    for (int i = 0; i < 6; ++i)
+    {
+        float theta = 2.0f * 3.14f * float(i) / float(6);
+        body[2 * i] = (PLAYER_SIZE / 2) * cos(theta);
+        body[2 * i + 1] = (PLAYER_SIZE / 2) * sin(theta);
+    }
+    meshPolygon(playerBody, body, 6);
+
+    // Head (Pentagon)
+    float head[2 * 5];
+    for (int i = 0; i < 5; ++i)
+    {
+        float theta = 2.0f * 3.14f * float(i) / float(5);
+        head[2 * i] = (PLAYER_HEAD_SIZE / 2) * cos(theta);
+        head[2 * i + 1] = (PLAYER_HEAD_SIZE / 2) * sin(theta) + PLAYER_SIZE / 2;
+    }
+    meshPolygon(playerHead, head, 5);
+
+    // Eyes (Triangles)
+    meshTriangle(playerEyes, -PLAYER_HEAD_SIZE / 4, PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 4,
+                 -PLAYER_HEAD_SIZE / 6, PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 6,
+                 -PLAYER_HEAD_SIZE / 4, PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 6);
+    meshTriangle(playerEyes, PLAYER_HEAD_SIZE / 4, PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 4,
+                 PLAYER_HEAD_SIZE / 6, PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 6,
+                 PLAYER_HEAD_SIZE / 4, PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 6);
+
+    // Mouth (Arc)
+    float mouth[2 * 181];
+    for (int i = 0; i <= 180; ++i)
+    {
+        float theta = 3.14f * float(i) / float(180);
+        mouth[2 * i] = (PLAYER_HEAD_SIZE / 4) * cosf(theta);
+        mouth[2 * i + 1] = PLAYER_SIZE / 2 - PLAYER_HEAD_SIZE / 4 + (PLAYER_HEAD_SIZE / 8) * sinf(theta);
+    }
+    meshLineStrip(playerMouth, mouth, 181);
+
+    return {addMesh(circle),     addMesh(shuriken),   addMesh(heart),      addMesh(playerBody),
+            addMesh(playerHead), addMesh(playerEyes), addMesh(playerMouth)};
+}
+
+static const DrawMeshes meshes = buildMeshes();
+
+void drawRect(float x1, float y1, float x2, float y2)
+{
+    batchRect(x1, y1, x2, y2);
+}
+
+void drawCircle(int x, int y, float r)
+{
+    batchPush();
+    batchTranslate(x, y);
+    batchScale(r);
+    batchMesh(meshes.circle);
+    batchPop();
+}
+
+void drawShuriken(float x, float y, float r)
+{
+    batchPush();
+    batchTranslate(x, y);
+    batchScale(r);
+    batchMesh(meshes.shuriken);
+    batchPop();
+}
+
+void drawHeart(float x, float y)
+{
+    batchPush();
+    batchTranslate(x, y);
+    batchMesh(meshes.heart);
+    batchPop();
+}
+
+// Queued from the glyph atlas when there is one. Otherwise bitmap text cannot go through the batch,
+// so everything batched so far is drawn first to keep the layering.
+void drawText(float x, float y, std::string text)
+{
+    float color[3];
+    currentBatchColor(color);
+    if (textSupported())
+    {
+        static TextLabel label;
+        layoutText(label, x, y, text, color);
+        queueText(label);
+        return;
+    }
+
+    flushBatch();
+    glColor3fv(color);
+    glRasterPos2f(x, y);
+    for (char c : text)
+    {
+        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, c);
+    }
+}
+
+// Queues `label` in the current color, laying it out again only when `key` differs from the last call's.
+// make() builds the string, so frames where the value holds still format nothing.
+template <typename Make>
+static void drawLabel(TextLabel &label, long long key, float x, float y, Make make)
+{
+    if (!textSupported())
+    {
+        drawText(x, y, make());
+        return;
+    }
+    if (!label.laidOut || label.key != key)
+    {
+        float color[3];
+        currentBatchColor(color);
+        layoutText(label, x, y, make(), color);
+        label.key = key;
+    }
+    queueText(label);
+}
+
+void drawPlayer()
+{
+    batchPush();
+    batchTranslate(PLAYER_BASE_X, game.playerY);
+
+    batchLayer(LAYER_PLAYER_BODY);
+    batchColor(0.3f, 0.2f, 0.4f);
+    batchMesh(meshes.playerBody);
+
+    batchLayer(LAYER_PLAYER_HEAD);
+    batchColor(1.0f, 0.5f, 0.6f);
+    batchMesh(meshes.playerHead);
+
+    batchLayer(LAYER_PLAYER_FACE);
+    batchColor(0.0f, 0.0f, 0.0f);
+    batchMesh(meshes.playerEyes);
+
+    batchColor(1.0f, 0.0f, 0.0f);
+    batchMesh(meshes.playerMouth);
+
+    batchPop();
+}
+
+// Entity shapes in their own coordinates, centred on the origin
+static void obstacleShape()
+{
+    // Base (Rectangle)
+    entityLayer(ENTITY_OBSTACLE, 0);
+    batchColor(1.0f, 0.0f, 0.0f);
+    drawRect(OBSTACLE_SIZE / 2, OBSTACLE_SIZE / 2, -OBSTACLE_SIZE / 2, -OBSTACLE_SIZE / 2);
+
+    // Right (Triangle)
+    entityLayer(ENTITY_OBSTACLE, 1);
+    batchColor(0.8f, 0.2f, 0.2f);
+    batchTriangle(OBSTACLE_SIZE / 2, -OBSTACLE_SIZE / 2, OBSTACLE_SIZE / 2, OBSTACLE_SIZE / 2, OBSTACLE_SIZE, 0);
+}
+
+static void collectableShape()
+{
+    // Circle
+    entityLayer(ENTITY_COLLECTABLE, 0);
+    batchColor(1.0f, 1.0f, 0.0f);
+    drawCircle(0, 0, COLLECTABLE_SIZE / 2);
+
+    // Shuriken (Triangles)
+    entityLayer(ENTITY_COLLECTABLE, 1);
+    batchColor(1.0f, 0.5f, 0.1f);
+    drawShuriken(0, 0, COLLECTABLE_SIZE / 2);
+
+    // Center (Point)
+    entityLayer(ENTITY_COLLECTABLE, 2);
+    batchColor(1.0f, 0.0f, 0.0f);
+    batchPoint(0, 0, 5.0f);
+}
+
+static void powerupShape(bool isTypeOne)
+{
+    if (isTypeOne)
+    {
+        // Type One:
+        // Diamond shape
+        entityLayer(ENTITY_POWERUP1, 0);
+        batchColor(0.9f, 0.1f, 0.3f);
+        batchPush();
+        batchRotate(45);
+        drawRect(POWERUP_SIZE / 2, POWERUP_SIZE / 2, -POWERUP_SIZE / 2, -POWERUP_SIZE / 2);
+        batchPop();
+
+        // Shuriken shape
+        entityLayer(ENTITY_POWERUP1, 1);
+        batchColor(0.0f, 1.0f, 0.5f);
+        drawShuriken(0, 0, POWERUP_SIZE / 2);
+
+        // Inner lines
+        entityLayer(ENTITY_POWERUP1, 2);
+        batchColor(0.0f, 0.0f, 0.0f);
+        const float horizontal[] = {-POWERUP_SIZE / 2, 0, POWERUP_SIZE / 2, 0};
+        const float vertical[] = {0, POWERUP_SIZE / 2, 0, -POWERUP_SIZE / 2};
+        batchLineStrip(horizontal, 2);
+        batchLineStrip(vertical, 2);
+    }
+    else
+    {
+        // Type Two:
+        // Shuriken shape
+        entityLayer(ENTITY_POWERUP2, 0);
+        batchColor(0.0f, 1.0f, 0.0f);
+        drawShuriken(0, 0, POWERUP_SIZE / 2);
+        batchPush();
+        batchRotate(45);
+        drawShuriken(0, 0, POWERUP_SIZE / 2);
+        batchPop();
+
+        // Center circle
+        entityLayer(ENTITY_POWERUP2, 1);
+        batchColor(1.0f, 1.0f, 0.0f);
+        drawCircle(0, 0, POWERUP_SIZE / 6);
+    }
+}
+
+static void entityShape(int kind)
+{
+    switch (kind)
+    {
+    case ENTITY_OBSTACLE:
+        obstacleShape();
+        break;
+    case ENTITY_COLLECTABLE:
+        collectableShape();
+        break;
+    case ENTITY_POWERUP1:
+        powerupShape(true);
+        break;
+    case ENTITY_POWERUP2:
+        powerupShape(false);
+        break;
+    }
+}
+
+void drawObstacle(float x, float y)
+{
+    batchPush();
+    batchTranslate(x, y);
+    obstacleShape();
+    batchPop();
+}
+
+void drawCollectable(float x, float y)
+{
+    batchPush();
+    batchTranslate(x, y);
+    batchRotate(game.collectableAngle);
+    collectableShape();
+    batchPop();
+}
+
+void drawPowerup(float x, float y, bool isTypeOne)
+{
+    batchPush();
+    batchTranslate(x, y);
+    powerupShape(isTypeOne);
+    batchPop();
+}
+
+void drawEntity(int kind, float x, float y)
+{
+    switch (kind)
+    {
+    case ENTITY_OBSTACLE:
+        drawObstacle(x, y);
+        break;
+    case ENTITY_COLLECTABLE:
+        drawCollectable(x, y);
+        break;
+    case ENTITY_POWERUP1:
+        drawPowerup(x, y, true);
+        break;
+    case ENTITY_POWERUP2:
+        drawPowerup(x, y, false);
+        break;
+    }
+}
+
+// One instanced mesh per entity kind, made from the shapes above the first time they are needed
+static int entityMeshes[ENTITY_KINDS];
+static bool entityMeshesBuilt = false;
+
+static void buildEntityMeshes()
+{
+    std::vector<BatchVertex> vertices;
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        entityShape(kind);
+        takeBatch(vertices);
+        entityMeshes[kind] = createInstancedMesh(vertices);
+    }
+    entityMeshesBuilt = true;
+}
+
+// With instancing this is one draw call whatever the count. Everything batched so far is drawn first,
+// so the entities still cover it; whatever is batched afterwards still covers them.
+void drawEntityInstances(int kind, const MeshInstance *instances, int count)
+{
+    // Instanced draws go straight to the GL, so the other backends get the instances as commands
+    RenderBackend backend = renderBackend();
+    if (instancingSupported() && (backend == BACKEND_BUFFER || backend == BACKEND_LEGACY))
+    {
+        flushBatch();
+        if (!entityMeshesBuilt)
+            buildEntityMeshes();
+        drawInstances(entityMeshes[kind], instances, count);
+        return;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        batchPush();
+        batchTranslate(instances[i].x, instances[i].y);
+        batchRotate(instances[i].degrees);
+        entityShape(kind);
+        batchPop();
+    }
+}
+
+void drawEntities()
+{
+    static std::vector<MeshInstance> instances;
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        // Only collectables spin
+        float degrees = kind == ENTITY_COLLECTABLE ? game.collectableAngle : 0;
+        instances.clear();
+        for (auto &entity : game.entities[kind])
+        {
+            if (entity.active)
+            {
+                instances.push_back({entity.x, entity.y, degrees});
+            }
+        }
+        drawEntityInstances(kind, instances.data(), (int)instances.size());
+    }
+}
+
+void drawHealth()
+{
+    for (int i = 0; i < game.lives; i++)
+    {
+        // Heart shape
+        batchLayer(LAYER_HEARTS);
+        batchColor(1.0f, 0.0f, 0.0f);
+        drawHeart(30 + i * 40, WINDOW_HEIGHT - 30);
+
+        batchPush();
+        batchTranslate(30 + i * 40, WINDOW_HEIGHT - 45);
+        batchLayer(LAYER_HEART_LINES);
+        batchColor(0.0f, 0.0f, 0.0f);
+        const float line[] = {-10, 0, 10, 0};
+        batchLineStrip(line, 2);
+        batchPop();
+    }
+}
+
+void drawScore()
+{
+    static TextLabel label;
+    batchColor(1.0f, 1.0f, 1.0f);
+    drawLabel(label, game.score, WINDOW_WIDTH - 111, WINDOW_HEIGHT - 22,
+              [] { return "Score: " + std::to_string(game.score); });
+}
+
+void drawTime()
+{
+    static TextLabel label;
+    batchColor(1.0f, 1.0f, 1.0f);
+    drawLabel(label, int(game.gameTime), WINDOW_WIDTH / 2 - 55, WINDOW_HEIGHT - 22,
+              [] { return "Time: " + std::to_string(int(game.gameTime)); });
+}
+
+void drawPowerupsState()
+{
+    static TextLabel invincibility, doublePoints;
+    batchColor(1.0f, 1.0f, 1.0f);
+
+    // -1 stands for NONE; active timers are never negative
+    int powerup1 = game.isInvincible ? int(game.powerup1ActiveTime) : -1;
+    drawLabel(invincibility, powerup1, WINDOW_WIDTH / 2 + 111, WINDOW_HEIGHT - 22, [powerup1] {
+        return "Invincibility: " + (powerup1 < 0 ? std::string("NONE") : std::to_string(powerup1));
+    });
+
+    int powerup2 = game.isDoublePoints ? int(game.powerup2ActiveTime) : -1;
+    drawLabel(doublePoints, powerup2, WINDOW_WIDTH / 2 + 111, WINDOW_HEIGHT - 44, [powerup2] {
+        return "Double Points: " + (powerup2 < 0 ? std::string("NONE") : std::to_string(powerup2));
+    });
+}
+
+void drawBackground() {
+    // The layers cover the whole window; they are drawn at once, under everything batched after them
+    if (parallaxLoaded())
+    {
+        flushBatch();
+        drawParallax();
+        return;
+    }
+
+    // Background Color
+    glClearColor(0.0f, 0.1f, 0.9f, 1.0f);
+
+    // Sun
+    batchLayer(LAYER_SUN);
+    batchColor(1.0f, 1.0f, 0.0f);
+    drawCircle(WINDOW_WIDTH - 50, WINDOW_HEIGHT - 150, 25);
+
+    batchPush();
+    batchTranslate(-game.backgroundX, -90);
+
+    // Clouds
+    batchLayer(LAYER_CLOUDS);
+    batchColor(1.0f, 1.0f, 1.0f);
+    for (int i = 0; i < 4; i++)
+        drawRect(i * 200, WINDOW_HEIGHT - 50 - 100 * i, i * 200 + 100, WINDOW_HEIGHT - 100 * i);
+    batchPop();
+}
+
+void drawGameStart()
+{
+    static TextLabel start, controls, powerups;
+    batchColor(1.0f, 1.0f, 1.0f);
+    drawLabel(start, 0, WINDOW_WIDTH / 2 - 250, (float)WINDOW_HEIGHT / 2,
+              [] { return std::string("Press 'Space' to start, 'p' to pause, 'r' to restart, and 'Esc' to exit"); });
+    drawLabel(controls, 0, WINDOW_WIDTH / 2 - 100, (float)WINDOW_HEIGHT / 2 - 30,
+              [] { return std::string("Controls: 'j' to duck, 'k' to jump"); });
+    drawLabel(powerups, 0, WINDOW_WIDTH / 2 - 150, (float)WINDOW_HEIGHT / 2 - 60,
+              [] { return std::string("Powerups: Diamond - Invincibility, Shuriken - Double Points"); });
+}
+
+void drawGameOver()
+{
+    static TextLabel result, lives, time, score;
+    bool timeUp = game.gameTime <= 0;
+    if (timeUp)
+    {
+        batchColor(0.0f, 1.0f, 0.0f);
+    }
+    else
+    {
+        batchColor(1.0f, 0.0f, 0.0f);
+    }
+    drawLabel(result, timeUp, WINDOW_WIDTH / 2 - 50, (float)WINDOW_HEIGHT / 2,
+              [timeUp] { return std::string(timeUp ? "Time's Up!" : "Game Over!"); });
+
+    // The rest takes the color of the line above, so timeUp is part of their keys too
+    drawLabel(lives, game.lives * 2 + timeUp, WINDOW_WIDTH / 2 - 70, WINDOW_HEIGHT / 2 - 30,
+              [] { return "Lives Remaining: " + std::to_string(game.lives); });
+    drawLabel(time, int(game.gameTime) * 2 + timeUp, WINDOW_WIDTH / 2 - 70, WINDOW_HEIGHT / 2 - 60,
+              [] { return "Time Remaining: " + std::to_string(int(game.gameTime)); });
+    drawLabel(score, game.score * 2 + timeUp, WINDOW_WIDTH / 2 - 70, WINDOW_HEIGHT / 2 - 90,
+              [] { return "Final Score: " + std::to_string(game.score); });
+}
+
+void drawBoundaries()
+{
+    batchLayer(LAYER_BOUNDARIES);
+    batchColor(0.5f, 0.5f, 0.5f);
+    drawRect(0, WINDOW_HEIGHT - 55, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    drawRect(0, 0, WINDOW_WIDTH, PLAYER_BASE_Y - PLAYER_SIZE / 2);
+
+    batchLayer(LAYER_BOUNDARY_DETAILS);
+    batchColor(0.7f, 0.7f, 0.7f);
+    for (int i = 0; i < WINDOW_WIDTH; i += 111)
+    {
+        batchTriangle(i, WINDOW_HEIGHT - 55, i + 55, WINDOW_HEIGHT - 55, i + 25, WINDOW_HEIGHT - 25);
+    }
+
+    drawRect(0, PLAYER_BASE_Y - PLAYER_SIZE / 2, WINDOW_WIDTH, PLAYER_BASE_Y - PLAYER_SIZE / 2 - 20);
+    drawRect(0, PLAYER_BASE_Y - PLAYER_SIZE / 2 - 40, WINDOW_WIDTH, PLAYER_BASE_Y - PLAYER_SIZE / 2 - 60); 
+    drawRect(0, PLAYER_BASE_Y - PLAYER_SIZE / 2 - 80, WINDOW_WIDTH, PLAYER_BASE_Y - PLAYER_SIZE / 2 - 100);
+}
+
+// The in-game HUD: boundaries, health, score, time and powerups. Where the GL can render to a texture,
+// it is drawn into a layer only when a value it shows changes, and copied from there otherwise.
+// Everything it draws lies within these two bands, which the boundaries fill.
+const float HUD_BANDS[] = {0, PLAYER_BASE_Y - PLAYER_SIZE / 2, WINDOW_HEIGHT - 55, WINDOW_HEIGHT};
+
+// What the HUD shows; powerups are -1 when off, as in drawPowerupsState()
+struct HudKey
+{
+    int lives, score, seconds, powerup1, powerup2;
+};
+
+static HudKey currentHudKey()
+{
+    return {game.lives, game.score, int(game.gameTime), game.isInvincible ? int(game.powerup1ActiveTime) : -1,
+            game.isDoublePoints ? int(game.powerup2ActiveTime) : -1};
+}
+
+static RenderLayer hudLayer;
+static HudKey shownHud;
+static bool hudLayerTried = false, hudLayerDrawn = false;
+
+// Redraws the HUD layer if it is out of date. Returns false if there is no layer,
+// in which case the HUD has to be drawn directly.
+static bool updateHudLayer()
+{
+    if (!hudLayerTried)
+    {
+        createRenderLayer(hudLayer, WINDOW_WIDTH, WINDOW_HEIGHT);
+        hudLayerTried = true;
+    }
+    if (!hudLayer.framebuffer)
+        return false;
+
+    HudKey key = currentHudKey();
+    if (hudLayerDrawn && !memcmp(&key, &shownHud, sizeof(key)))
+        return true;
+
+    flushText();
+    beginRenderLayer(hudLayer);
+    drawBoundaries();
+    drawHealth();
+    drawScore();
+    drawTime();
+    drawPowerupsState();
+    flushText();
+    endRenderLayer();
+
+    shownHud = key;
+    hudLayerDrawn = true;
+    return true;
+}
+
+void drawFrame()
+{
+    PhaseTimer timer;
+    glClear(GL_COLOR_BUFFER_BIT);
+    drawBackground();
+    timer.lap(PHASE_BACKGROUND);
+
+    bool hudFromLayer = false;
+    if (game.gameState == 1)
+    {
+        drawPlayer();
+        drawEntities();
+        timer.lap(PHASE_ENTITIES);
+
+        hudFromLayer = updateHudLayer();
+        if (!hudFromLayer)
+        {
+            drawBoundaries();
+            timer.lap(PHASE_BOUNDARIES);
+
+            drawHealth();
+        }
+        timer.lap(PHASE_HUD);
+    }
+
+    // The shapes still batched go out in one draw; only the text comes after
+    flushBatch();
+    if (hudFromLayer)
+    {
+        drawRenderLayer(hudLayer, HUD_BANDS, 2);
+    }
+    timer.lap(PHASE_SUBMIT);
+
+    if (game.gameState == 0)
+    {
+        drawGameStart();
+    }
+    else if (game.gameState == 1)
+    {
+        if (!hudFromLayer)
+        {
+            drawScore();
+            drawTime();
+            drawPowerupsState();
+        }
+    }
+    else
+    {
+        drawGameOver();
+    }
+    flushText();
+    timer.lap(PHASE_TEXT);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include "Renderer.h"
+#include "Simulation.h"
+
+// The game the draw functions show; main.cpp and the benchmark each own one
+extern GameState game;
+
+// Drawing of every part of the screen, in window coordinates. Shapes go into the batch of Renderer.h,
+// which drawFrame() flushes once; entities are drawn instanced, one call per kind, where the GL allows.
+// Call initRenderer() once the GL context exists.
+void drawRect(float, float, float, float);
+void drawCircle(int, int, float);
+void drawShuriken(float, float, float);
+void drawHeart(float, float);
+void drawText(float, float, std::string);
+void drawPlayer();
+void drawObstacle(float, float);
+void drawCollectable(float, float);
+void drawPowerup(float, float, bool);
+void drawEntity(int, float, float);
+void drawEntityInstances(int, const MeshInstance *, int); // one instanced draw when the GL supports it
+void drawEntities();
+void drawHealth();
+void drawScore();
+void drawTime();
+void drawPowerupsState();
+void drawBackground();
+void drawGameStart();
+void drawGameOver();
+void drawBoundaries();
+
+// Clears and draws the whole screen for the current game state
+void drawFrame();
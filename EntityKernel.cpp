@@ -0,0 +1,225 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "EntityKernel.h"
+#include "Simulation.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define ENTITY_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+typedef void (*EntityKernel)(float *, float *, int, double, const float *, const float *, const float *, float, float,
+                             unsigned int *, unsigned int *);
+
+// Scalar loop over entities [first, count)
+static void advanceRange(float *x, float *y, int first, int count, double k, const float *speed, const float *dy,
+                         const float *playerY, float reach, float cullX, unsigned int *overlaps, unsigned int *culled)
+{
+    for (int j = first; j < count; j++)
+    {
+        x[j] -= k * speed[j];
+        if (dy)
+            y[j] += dy[j];
+
+        unsigned int bit = 1u << (j % 32);
+        if (std::abs(x[j] - PLAYER_BASE_X) < reach && std::abs(y[j] - playerY[j]) < reach)
+            overlaps[j / 32] |= bit;
+        if (x[j] < cullX)
+            culled[j / 32] |= bit;
+    }
+}
+
+static void advanceEntitiesScalar(float *x, float *y, int count, double k, const float *speed, const float *dy,
+                                  const float *playerY, float reach, float cullX, unsigned int *overlaps, unsigned int *culled)
+{
+    advanceRange(x, y, 0, count, k, speed, dy, playerY, reach, cullX, overlaps, culled);
+}
+
+#ifdef ENTITY_KERNEL_X86
+
+TARGET_SSE2 static void advanceEntitiesSse2(float *x, float *y, int count, double k, const float *speed, const float *dy,
+                                            const float *playerY, float reach, float cullX, unsigned int *overlaps,
+                                            unsigned int *culled)
+{
+    const __m128d k2 = _mm_set1_pd(k);
+    const __m128 px4 = _mm_set1_ps(PLAYER_BASE_X);
+    const __m128 reach4 = _mm_set1_ps(reach);
+    const __m128 cull4 = _mm_set1_ps(cullX);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+    int j = 0;
+    for (; j + 4 <= count; j += 4)
+    {
+        __m128 speeds = _mm_loadu_ps(speed + j);
+        __m128 xs = _mm_loadu_ps(x + j);
+        __m128d lo = _mm_sub_pd(_mm_cvtps_pd(xs), _mm_mul_pd(k2, _mm_cvtps_pd(speeds)));
+        __m128d hi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(xs, xs)), _mm_mul_pd(k2, _mm_cvtps_pd(_mm_movehl_ps(speeds, speeds))));
+        xs = _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+        __m128 ys = _mm_loadu_ps(y + j);
+        if (dy)
+            ys = _mm_add_ps(ys, _mm_loadu_ps(dy + j));
+        _mm_storeu_ps(x + j, xs);
+        _mm_storeu_ps(y + j, ys);
+
+        __m128 nearX = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(xs, px4), absMask), reach4);
+        __m128 nearY = _mm_cmplt_ps(_mm_and_ps(_mm_sub_ps(ys, _mm_loadu_ps(playerY + j)), absMask), reach4);
+        unsigned int hit = _mm_movemask_ps(_mm_and_ps(nearX, nearY));
+        unsigned int gone = _mm_movemask_ps(_mm_cmplt_ps(xs, cull4));
+        overlaps[j / 32] |= hit << (j % 32);
+        culled[j / 32] |= gone << (j % 32);
+    }
+
+    advanceRange(x, y, j, count, k, speed, dy, playerY, reach, cullX, overlaps, culled);
+}
+
+// One 8-wide step over entities [j, j + 8); lanes outside `mask` are neither read nor written
+TARGET_AVX static inline void advanceAvx8(float *x, float *y, int j, __m256i mask, bool partial, __m256d k4,
+                                          const float *speed, const float *dy, const float *playerY, __m256 reach8,
+                                          __m256 cull8, unsigned int *overlaps, unsigned int *culled)
+{
+    const __m256 px8 = _mm256_set1_ps(PLAYER_BASE_X);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+    __m256 speeds, xs, ys, py;
+    if (partial)
+    {
+        speeds = _mm256_maskload_ps(speed + j, mask);
+        xs = _mm256_maskload_ps(x + j, mask);
+        ys = _mm256_maskload_ps(y + j, mask);
+        py = _mm256_maskload_ps(playerY + j, mask);
+        if (dy)
+            ys = _mm256_add_ps(ys, _mm256_maskload_ps(dy + j, mask));
+    }
+    else
+    {
+        speeds = _mm256_loadu_ps(speed + j);
+        xs = _mm256_loadu_ps(x + j);
+        ys = _mm256_loadu_ps(y + j);
+        py = _mm256_loadu_ps(playerY + j);
+        if (dy)
+            ys = _mm256_add_ps(ys, _mm256_loadu_ps(dy + j));
+    }
+
+    __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(xs)),
+                               _mm256_mul_pd(k4, _mm256_cvtps_pd(_mm256_castps256_ps128(speeds))));
+    __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(xs, 1)),
+                               _mm256_mul_pd(k4, _mm256_cvtps_pd(_mm256_extractf128_ps(speeds, 1))));
+    xs = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+
+    if (partial)
+    {
+        _mm256_maskstore_ps(x + j, mask, xs);
+        _mm256_maskstore_ps(y + j, mask, ys);
+    }
+    else
+    {
+        _mm256_storeu_ps(x + j, xs);
+        _mm256_storeu_ps(y + j, ys);
+    }
+
+    __m256 nearX = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(xs, px8), absMask), reach8, _CMP_LT_OQ);
+    __m256 nearY = _mm256_cmp_ps(_mm256_and_ps(_mm256_sub_ps(ys, py), absMask), reach8, _CMP_LT_OQ);
+    unsigned int valid = _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+    unsigned int hit = _mm256_movemask_ps(_mm256_and_ps(nearX, nearY)) & valid;
+    unsigned int gone = _mm256_movemask_ps(_mm256_cmp_ps(xs, cull8, _CMP_LT_OQ)) & valid;
+    overlaps[j / 32] |= hit << (j % 32);
+    culled[j / 32] |= gone << (j % 32);
+}
+
+// The tail goes through masked loads and stores so every entity takes the vector path
+TARGET_AVX static void advanceEntitiesAvx(float *x, float *y, int count, double k, const float *speed, const float *dy,
+                                          const float *playerY, float reach, float cullX, unsigned int *overlaps,
+                                          unsigned int *culled)
+{
+    const __m256d k4 = _mm256_set1_pd(k);
+    const __m256 reach8 = _mm256_set1_ps(reach);
+    const __m256 cull8 = _mm256_set1_ps(cullX);
+
+    int j = 0;
+    for (; j + 8 <= count; j += 8)
+        advanceAvx8(x, y, j, _mm256_set1_epi32(-1), false, k4, speed, dy, playerY, reach8, cull8, overlaps, culled);
+
+    if (j < count)
+    {
+        const __m256 lanes = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i mask = _mm256_castps_si256(_mm256_cmp_ps(lanes, _mm256_set1_ps(float(count - j)), _CMP_LT_OQ));
+        advanceAvx8(x, y, j, mask, true, k4, speed, dy, playerY, reach8, cull8, overlaps, culled);
+    }
+}
+
+static bool cpuHasSse2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool cpuHasAvx()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSaves = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    return osSaves && avx && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+#endif
+
+struct KernelChoice
+{
+    EntityKernel advance;
+    const char *name;
+};
+
+// ENTITY_KERNEL=scalar or ENTITY_KERNEL=sse2 in the environment caps the choice, for comparing paths
+static KernelChoice selectKernel()
+{
+    const char *cap = getenv("ENTITY_KERNEL");
+    bool allowSse2 = !cap || strcmp(cap, "scalar") != 0;
+    bool allowAvx = allowSse2 && (!cap || strcmp(cap, "sse2") != 0);
+#ifdef ENTITY_KERNEL_X86
+    if (allowAvx && cpuHasAvx())
+        return {advanceEntitiesAvx, "avx"};
+    if (allowSse2 && cpuHasSse2())
+        return {advanceEntitiesSse2, "sse2"};
+#endif
+    return {advanceEntitiesScalar, "scalar"};
+}
+
+// Picked on first use, so callers from other files' static initializers get a kernel too
+static const KernelChoice &kernel()
+{
+    static const KernelChoice choice = selectKernel();
+    return choice;
+}
+
+void advanceEntities(float *x, float *y, int count, double k, const float *speed, const float *dy, const float *playerY,
+                     float reach, float cullX, unsigned int *overlaps, unsigned int *culled)
+{
+    if (count > 0)
+        kernel().advance(x, y, count, k, speed, dy, playerY, reach, cullX, overlaps, culled);
+}
+
+const char *entityKernelName()
+{
+    return kernel().name;
+}
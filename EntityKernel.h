@@ -0,0 +1,13 @@
+#pragma once
+
+// Moves a whole entity array in one call and reports, one bit per entity,
+// which ones overlap the player and which ones left the screen.
+// Entity j moves left by k * speed[j] and up by dy[j] (dy may be null), then is tested against a player at playerY[j].
+// x is advanced in double precision like `x -= k * gameSpeed` in step(), so results match it bit for bit.
+// Bit j of mask word j / 32 belongs to entity j; the caller clears the mask words.
+// The AVX, SSE2 or scalar implementation is picked once, on the first call.
+void advanceEntities(float *x, float *y, int count, double k, const float *speed, const float *dy, const float *playerY,
+                     float reach, float cullX, unsigned int *overlaps, unsigned int *culled);
+
+// Name of the implementation advanceEntities() dispatches to
+const char *entityKernelName();
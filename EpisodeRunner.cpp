@@ -0,0 +1,104 @@
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "EpisodeRunner.h"
+
+// One worker's queue of episode indices. The owner takes from the back, thieves from the front,
+// so they only meet on the last episode. An episode is long enough that a lock per deque is cheap.
+struct WorkQueue
+{
+    std::mutex lock;
+    std::deque<int> episodes;
+
+    bool popBack(int &episode)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (episodes.empty())
+            return false;
+        episode = episodes.back();
+        episodes.pop_back();
+        return true;
+    }
+
+    bool stealFront(int &episode)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (episodes.empty())
+            return false;
+        episode = episodes.front();
+        episodes.pop_front();
+        return true;
+    }
+};
+
+static EpisodeResult playEpisode(const Episode &episode)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    GameState state;
+    initGame(state, episode.seed);
+    pressKey(state, ' ');
+
+    long long ticks = 0;
+    while (state.gameState != 2 && ticks < episode.maxTicks)
+    {
+        step(state, episode.policy(state, episode.context));
+        ticks++;
+    }
+
+    EpisodeResult result;
+    result.score = state.score;
+    result.lives = state.lives;
+    result.ticks = ticks;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void runWorker(int self, std::vector<WorkQueue> &queues, const std::vector<Episode> &episodes,
+                      std::vector<EpisodeResult> &results)
+{
+    int workers = (int)queues.size();
+    for (;;)
+    {
+        int episode;
+        bool found = queues[self].popBack(episode);
+
+        // Nothing new is ever queued, so once every queue is empty the work is done
+        for (int k = 1; !found && k < workers; k++)
+            found = queues[(self + k) % workers].stealFront(episode);
+        if (!found)
+            return;
+
+        results[episode] = playEpisode(episodes[episode]);
+    }
+}
+
+std::vector<EpisodeResult> runEpisodes(const std::vector<Episode> &episodes, int threads)
+{
+    int count = (int)episodes.size();
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0)
+        threads = 1;
+    if (threads > count)
+        threads = count > 0 ? count : 1;
+
+    // Each worker starts with a contiguous share and steals once it runs out
+    std::vector<WorkQueue> queues(threads);
+    for (int w = 0; w < threads; w++)
+    {
+        for (int e = (long long)count * w / threads; e < (long long)count * (w + 1) / threads; e++)
+            queues[w].episodes.push_back(e);
+    }
+
+    std::vector<EpisodeResult> results(count);
+    std::vector<std::thread> workers;
+    for (int w = 1; w < threads; w++)
+        workers.emplace_back(runWorker, w, std::ref(queues), std::cref(episodes), std::ref(results));
+    runWorker(0, queues, episodes, results);
+    for (auto &worker : workers)
+        worker.join();
+    return results;
+}
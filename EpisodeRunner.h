@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "Simulation.h"
+
+// Picks the keys for the next tick; `context` is passed through from the episode
+typedef GameInput (*Policy)(const GameState &, void *context);
+
+struct Episode
+{
+    unsigned long long seed;
+    Policy policy;
+    void *context;     // shared by every worker that runs this episode's policy
+    long long maxTicks; // stops a policy that never finishes, e.g. one that stays paused
+};
+
+struct EpisodeResult
+{
+    int score;
+    int lives;
+    long long ticks;
+    double seconds;
+};
+
+// Plays each episode from a started game until game over or maxTicks.
+// Episodes are spread over `threads` workers (0: one per core) that steal from each other when they run dry,
+// since losing every life ends some games far sooner than others.
+// Results come back in episode order and do not depend on the thread count.
+std::vector<EpisodeResult> runEpisodes(const std::vector<Episode> &, int threads);
@@ -0,0 +1,245 @@
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FrameCapture.h"
+#include "Profiler.h"
+
+// Frames in flight; each is one full RGB image
+const int CAPTURE_BUFFERS = 8;
+
+static std::mutex captureMutex;
+static std::condition_variable captureWake;
+static std::vector<std::vector<unsigned char>> buffers;
+static std::deque<unsigned char *> freeBuffers, queuedFrames;
+static unsigned char *current;
+static bool stopping;
+static bool failed;
+static std::thread writer;
+static long long waited;
+
+static std::string pattern;
+static FILE *video; // the Y4M stream, or null while writing PPM files
+static int frameWidth, frameHeight;
+static int frameNumber;
+static std::vector<unsigned char> planes;
+
+static bool isY4m(const char *path)
+{
+    size_t length = strlen(path);
+    return length >= 4 && strcmp(path + length - 4, ".y4m") == 0;
+}
+
+// The pattern goes to snprintf as its format, so it may take nothing but the one int it is given:
+// a single %d or %i with optional 0 or - flags and width, and %% for a literal percent sign
+static bool isFramePattern(const char *path)
+{
+    int conversions = 0;
+    for (const char *c = path; *c; c++)
+    {
+        if (*c != '%')
+            continue;
+        c++;
+        if (*c == '%')
+            continue;
+        while (*c == '0' || *c == '-')
+            c++;
+        while (*c >= '0' && *c <= '9')
+            c++;
+        if (*c != 'd' && *c != 'i')
+            return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+bool isCapturePath(const char *path)
+{
+    return isY4m(path) || isFramePattern(path);
+}
+
+// False if the name does not fit
+static bool framePath(char *path, size_t size, int number)
+{
+    int length = snprintf(path, size, pattern.c_str(), number);
+    return length >= 0 && (size_t)length < size;
+}
+
+// BT.601 studio range, as players expect from Y4M without a color range tag; each chroma sample
+// averages the 2x2 pixels it covers, which is the centered siting C420jpeg promises
+static void writeY4mFrame(const unsigned char *rgb)
+{
+    int chromaWidth = (frameWidth + 1) / 2;
+    int chromaHeight = (frameHeight + 1) / 2;
+    unsigned char *y = planes.data();
+    unsigned char *u = y + frameWidth * frameHeight;
+    unsigned char *v = u + chromaWidth * chromaHeight;
+
+    for (int i = 0; i < frameWidth * frameHeight; i++)
+    {
+        const unsigned char *pixel = &rgb[i * 3];
+        y[i] = (unsigned char)(16 + ((66 * pixel[0] + 129 * pixel[1] + 25 * pixel[2] + 128) >> 8));
+    }
+    for (int cy = 0; cy < chromaHeight; cy++)
+    {
+        for (int cx = 0; cx < chromaWidth; cx++)
+        {
+            int r = 0, g = 0, b = 0, count = 0;
+            for (int py = 2 * cy; py < 2 * cy + 2 && py < frameHeight; py++)
+            {
+                for (int px = 2 * cx; px < 2 * cx + 2 && px < frameWidth; px++)
+                {
+                    const unsigned char *pixel = &rgb[(py * frameWidth + px) * 3];
+                    r += pixel[0];
+                    g += pixel[1];
+                    b += pixel[2];
+                    count++;
+                }
+            }
+            r /= count;
+            g /= count;
+            b /= count;
+            u[cy * chromaWidth + cx] = (unsigned char)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+            v[cy * chromaWidth + cx] = (unsigned char)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+        }
+    }
+
+    fputs("FRAME\n", video);
+    if (fwrite(planes.data(), 1, planes.size(), video) != planes.size())
+        failed = true;
+}
+
+static void writePpmFrame(const unsigned char *rgb)
+{
+    char path[1024];
+    FILE *file = framePath(path, sizeof(path), frameNumber) ? fopen(path, "wb") : nullptr;
+    if (!file)
+    {
+        failed = true;
+        return;
+    }
+    size_t bytes = (size_t)frameWidth * frameHeight * 3;
+    fprintf(file, "P6\n%d %d\n255\n", frameWidth, frameHeight);
+    if (fwrite(rgb, 1, bytes, file) != bytes)
+        failed = true;
+    if (fclose(file) != 0)
+        failed = true;
+}
+
+static void writeFrames()
+{
+    std::unique_lock<std::mutex> lock(captureMutex);
+    for (;;)
+    {
+        captureWake.wait(lock, [] { return stopping || !queuedFrames.empty(); });
+        if (queuedFrames.empty())
+            return;
+        unsigned char *frame = queuedFrames.front();
+        queuedFrames.pop_front();
+        lock.unlock();
+
+        // Once a write has failed, frames are only handed back, so the caller never stalls on them
+        if (!failed)
+        {
+            if (video)
+                writeY4mFrame(frame);
+            else
+                writePpmFrame(frame);
+        }
+        frameNumber++;
+
+        lock.lock();
+        freeBuffers.push_back(frame);
+        captureWake.notify_all();
+    }
+}
+
+bool startCapture(const char *path, int width, int height, int fps)
+{
+    if (!isCapturePath(path))
+        return false;
+    pattern = path;
+    frameWidth = width;
+    frameHeight = height;
+    frameNumber = 0;
+    failed = false;
+    stopping = false;
+    waited = 0;
+    video = nullptr;
+    if (isY4m(path))
+    {
+        video = fopen(path, "wb");
+        if (!video)
+            return false;
+        fprintf(video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+        planes.resize((size_t)width * height + 2 * (size_t)((width + 1) / 2) * ((height + 1) / 2));
+    }
+    else
+    {
+        // Fail now, not on the writer thread, if the first file cannot be made
+        char first[1024];
+        FILE *file = framePath(first, sizeof(first), 0) ? fopen(first, "wb") : nullptr;
+        if (!file)
+            return false;
+        fclose(file);
+    }
+
+    buffers.assign(CAPTURE_BUFFERS, std::vector<unsigned char>((size_t)width * height * 3));
+    freeBuffers.clear();
+    queuedFrames.clear();
+    for (auto &buffer : buffers)
+        freeBuffers.push_back(buffer.data());
+    current = nullptr;
+    writer = std::thread(writeFrames);
+    return true;
+}
+
+unsigned char *captureFrame()
+{
+    std::unique_lock<std::mutex> lock(captureMutex);
+    if (freeBuffers.empty())
+    {
+        long long start = profileNow();
+        captureWake.wait(lock, [] { return !freeBuffers.empty(); });
+        waited += profileNow() - start;
+    }
+    current = freeBuffers.front();
+    freeBuffers.pop_front();
+    return current;
+}
+
+void submitFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        queuedFrames.push_back(current);
+        current = nullptr;
+    }
+    captureWake.notify_all();
+}
+
+bool stopCapture()
+{
+    {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        stopping = true;
+    }
+    captureWake.notify_all();
+    writer.join();
+
+    if (video && fclose(video) != 0)
+        failed = true;
+    video = nullptr;
+    buffers.clear();
+    freeBuffers.clear();
+    return !failed;
+}
+
+long long captureWaitTime()
+{
+    return waited;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Video output for runs without a display: RGB frames, top row first, go to a raw Y4M file or a
+// numbered PPM sequence. Converting and writing happen on a background thread; frames wait for it
+// in a bounded pool of buffers, so the caller only ever waits when every buffer is still queued.
+
+// `path` ending in .y4m writes one 4:2:0 Y4M stream at `fps`; anything else is a printf pattern
+// for one PPM per frame, such as "frames/%05d.ppm". Returns false if isCapturePath() rejects `path`
+// or the first file cannot be created.
+bool startCapture(const char *path, int width, int height, int fps);
+
+// True for a .y4m path, or a PPM pattern with exactly one integer conversion (%d or %i, with
+// optional 0 or - flags and width) and no other conversion but %%
+bool isCapturePath(const char *path);
+
+// A free width * height * 3 buffer to render the next frame into, until submitFrame()
+unsigned char *captureFrame();
+
+// Queues the buffer from captureFrame() for writing
+void submitFrame();
+
+// Writes out every queued frame and closes the output; returns false if any write failed
+bool stopCapture();
+
+// Nanoseconds captureFrame() has spent waiting for a free buffer since startCapture()
+long long captureWaitTime();
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "BatchSimulation.h"
+#include "EntityKernel.h"
+#include "EpisodeRunner.h"
+#include "FrameCapture.h"
+#include "PixelRenderer.h"
+#include "Planner.h"
+#include "Replay.h"
+#include "Simulation.h"
+
+// Runs the simulation without a window as fast as the CPU allows.
+// Usage: Headless [--record <file>] [ticks] [seed] [games] [threads]
+//        Headless --replay <file>
+//        Headless --episodes <count> [seed] [threads]
+//        Headless --planner <count> [seed] [budget ms] [threads]
+//        Headless --capture <replay file> <video> [width] [height]
+// With more than one game, every tick steps the whole batch at once, split over `threads` (0: one per core).
+// --episodes plays whole games with seeds seed, seed + 1, ... on all cores.
+// --planner plays whole games with the lookahead planner, one decision per tick, and reports how far
+// each got up the speed ramp and how much of the per-tick budget the decisions used.
+// --record saves the bot's single-game run as a replay; --replay re-runs one and checks the final score and lives.
+// --capture re-runs a replay and renders every tick in software into <video>: a .y4m file at FPS,
+// or a printf pattern for PPM files such as frames/%05d.ppm. Frames are WINDOW_WIDTH x WINDOW_HEIGHT
+// by default, at most MAX_CAPTURE_SIZE each way, and show what PixelRenderer draws: the play screen
+// without text or hearts.
+
+// Largest --capture width or height; eight buffers of a 8192x8192 RGB frame are already 1.5 GB
+const int MAX_CAPTURE_SIZE = 8192;
+
+// Simple bot: jump over the nearest obstacle that is about to reach the player
+GameInput botInput(const GameState &state)
+{
+    GameInput input = {0};
+    if (state.gameState != 1)
+    {
+        input.keys = state.gameState == 0 ? INPUT_START : INPUT_RESTART;
+        return input;
+    }
+
+    for (auto &obstacle : state.entities[ENTITY_OBSTACLE])
+    {
+        float distance = obstacle.x - PLAYER_BASE_X;
+        if (obstacle.active && distance > 0 && distance < 4 * PLAYER_SIZE)
+        {
+            input.keys = INPUT_JUMP;
+            break;
+        }
+    }
+    return input;
+}
+
+// Same bot for game i of a batch
+GameInput botInput(const BatchState &batch, int i)
+{
+    GameInput input = {0};
+    if (batch.gameState[i] != 1)
+    {
+        input.keys = batch.gameState[i] == 0 ? INPUT_START : INPUT_RESTART;
+        return input;
+    }
+
+    for (int j = 0; j < batch.entityCount[ENTITY_OBSTACLE][i]; j++)
+    {
+        float distance = batch.entityX[ENTITY_OBSTACLE][j * batch.count + i] - PLAYER_BASE_X;
+        if (distance > 0 && distance < 4 * PLAYER_SIZE)
+        {
+            input.keys = INPUT_JUMP;
+            break;
+        }
+    }
+    return input;
+}
+
+struct BotJob
+{
+    BatchState *batch;
+    GameInput *inputs;
+};
+
+// The bot's choices and the step for one worker's share of the games
+static void botShare(void *context, int begin, int end)
+{
+    BotJob &job = *(BotJob *)context;
+    for (int i = begin; i < end; i++)
+        job.inputs[i] = botInput(*job.batch, i);
+    stepBatch(*job.batch, job.inputs, begin, end);
+}
+
+void runBatch(long long ticks, unsigned int seed, int count, int threads)
+{
+    BatchState batch;
+    initBatch(batch, count, seed);
+    std::vector<GameInput> inputs(count);
+    BatchWorkers workers(threads);
+    BotJob job = {&batch, inputs.data()};
+
+    long long games = 0;
+    long long totalScore = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long t = 0; t < ticks; t++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (batch.gameState[i] == 2)
+            {
+                games++;
+                totalScore += batch.score[i];
+            }
+        }
+        workers.run(count, botShare, &job);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("ticks: %lld x %d games on %zu threads\n", ticks, count, workers.helpers.size() + 1);
+    printf("entity kernel: %s\n", entityKernelName());
+    printf("games: %lld\n", games);
+    printf("average score: %.1f\n", games ? double(totalScore) / games : 0.0);
+    printf("seconds: %.3f\n", seconds);
+    printf("steps/sec: %.0f\n", ticks * count / seconds);
+}
+
+static GameInput botPolicy(const GameState &state, void *)
+{
+    return botInput(state);
+}
+
+void runBotEpisodes(int count, unsigned int seed, int threads)
+{
+    std::vector<Episode> episodes(count);
+    for (int e = 0; e < count; e++)
+        episodes[e] = {seed + (unsigned long long)e, botPolicy, nullptr, 1000000};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<EpisodeResult> results = runEpisodes(episodes, threads);
+    auto end = std::chrono::steady_clock::now();
+
+    long long totalScore = 0;
+    long long totalTicks = 0;
+    long long shortest = count ? results[0].ticks : 0;
+    long long longest = 0;
+    for (auto &result : results)
+    {
+        totalScore += result.score;
+        totalTicks += result.ticks;
+        shortest = std::min(shortest, result.ticks);
+        longest = std::max(longest, result.ticks);
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("episodes: %d\n", count);
+    printf("average score: %.1f\n", count ? double(totalScore) / count : 0.0);
+    printf("ticks per episode: %lld to %lld\n", shortest, longest);
+    printf("seconds: %.3f\n", seconds);
+    printf("episodes/sec: %.0f\n", count / seconds);
+    printf("ticks/sec: %.0f\n", totalTicks / seconds);
+}
+
+void runPlannerEpisodes(int count, unsigned int seed, double budgetMs, int threads)
+{
+    PlannerConfig config = DEFAULT_PLANNER_CONFIG;
+    config.budgetSeconds = budgetMs / 1000;
+    config.threads = threads;
+
+    long long totalScore = 0;
+    for (int e = 0; e < count; e++)
+    {
+        GameState state;
+        initGame(state, seed + (unsigned long long)e);
+        step(state, planAction(state, config));
+
+        long long ticks = 0;
+        long long overBudget = 0;
+        long long shallow = 0;
+        double decisionSeconds = 0;
+        double slowest = 0;
+        while (state.gameState == 1)
+        {
+            PlannerStats stats;
+            step(state, planAction(state, config, &stats));
+            ticks++;
+            decisionSeconds += stats.seconds;
+            slowest = std::max(slowest, stats.seconds);
+            if (stats.seconds > config.budgetSeconds)
+                overBudget++;
+            if (stats.depth + config.actionRepeat <= config.horizon)
+                shallow++;
+        }
+        totalScore += state.score;
+
+        printf("episode %d: score %d, lives %d, ticks %lld, speed %.2f, decision %.3f ms avg %.3f ms max, "
+               "%lld over budget, %lld cut short\n",
+               e, state.score, state.lives, ticks, state.gameSpeed, ticks ? decisionSeconds * 1000 / ticks : 0.0,
+               slowest * 1000, overBudget, shallow);
+    }
+    printf("average score: %.1f\n", count ? double(totalScore) / count : 0.0);
+}
+
+// Returns 0 if the replay ends with the recorded score and lives
+int runReplayFile(const char *path)
+{
+    Replay replay;
+    if (!loadReplay(path, replay))
+    {
+        fprintf(stderr, "could not read replay %s\n", path);
+        return 2;
+    }
+
+    GameState state;
+    auto start = std::chrono::steady_clock::now();
+    runReplay(replay, state);
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    bool matches = state.score == replay.finalScore && state.lives == replay.finalLives;
+    printf("ticks: %zu\n", replay.inputs.size());
+    printf("score: %d (recorded %d)\n", state.score, replay.finalScore);
+    printf("lives: %d (recorded %d)\n", state.lives, replay.finalLives);
+    printf("seconds: %.3f\n", seconds);
+    printf("%s\n", matches ? "OK" : "MISMATCH");
+    return matches ? 0 : 1;
+}
+
+// A whole decimal number in [1, MAX_CAPTURE_SIZE], or 0 if `text` is anything else
+static int parseCaptureSize(const char *text)
+{
+    char *end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 1 || value > MAX_CAPTURE_SIZE)
+        return 0;
+    return (int)value;
+}
+
+// Returns 0 once every frame is written
+int captureReplay(const char *path, const char *videoPath, int width, int height)
+{
+    Replay replay;
+    if (!loadReplay(path, replay))
+    {
+        fprintf(stderr, "could not read replay %s\n", path);
+        return 2;
+    }
+    if (!startCapture(videoPath, width, height, FPS))
+    {
+        fprintf(stderr, "could not write video to %s\n", videoPath);
+        return 2;
+    }
+
+    // The tick only renders into a free buffer; conversion and disk writes happen on the capture thread
+    GameState state;
+    initGame(state, replay.seed);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned char keys : replay.inputs)
+    {
+        step(state, GameInput{keys});
+        renderGame(state, captureFrame(), width, height, PIXELS_RGB);
+        submitFrame();
+    }
+    long long waited = captureWaitTime();
+    bool written = stopCapture();
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("frames: %zu at %dx%d\n", replay.inputs.size(), width, height);
+    printf("seconds: %.3f\n", seconds);
+    printf("frames/sec: %.0f\n", replay.inputs.size() / seconds);
+    printf("waiting for the writer: %.3f s\n", waited / 1e9);
+    if (!written)
+    {
+        fprintf(stderr, "could not write every frame to %s\n", videoPath);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+        return runReplayFile(argv[2]);
+    if (argc > 3 && strcmp(argv[1], "--capture") == 0)
+    {
+        int width = argc > 4 ? parseCaptureSize(argv[4]) : WINDOW_WIDTH;
+        int height = argc > 5 ? parseCaptureSize(argv[5]) : WINDOW_HEIGHT;
+        if (width == 0 || height == 0)
+        {
+            fprintf(stderr, "usage: Headless --capture <replay file> <video> [width] [height]\n"
+                            "width and height must be whole numbers from 1 to %d\n", MAX_CAPTURE_SIZE);
+            return 2;
+        }
+        if (!isCapturePath(argv[3]))
+        {
+            fprintf(stderr, "usage: Headless --capture <replay file> <video> [width] [height]\n"
+                            "<video> must end in .y4m or hold exactly one %%d, such as frames/%%05d.ppm\n");
+            return 2;
+        }
+        return captureReplay(argv[2], argv[3], width, height);
+    }
+    if (argc > 2 && strcmp(argv[1], "--episodes") == 0)
+    {
+        unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+        int threads = argc > 4 ? atoi(argv[4]) : 0;
+        runBotEpisodes(atoi(argv[2]), seed, threads);
+        return 0;
+    }
+
+    if (argc > 2 && strcmp(argv[1], "--planner") == 0)
+    {
+        unsigned int seed = argc > 3 ? (unsigned int)atoi(argv[3]) : 1;
+        double budgetMs = argc > 4 ? atof(argv[4]) : DEFAULT_PLANNER_CONFIG.budgetSeconds * 1000;
+        int threads = argc > 5 ? atoi(argv[5]) : 1;
+        runPlannerEpisodes(atoi(argv[2]), seed, budgetMs, threads);
+        return 0;
+    }
+
+    const char *recordPath = nullptr;
+    if (argc > 2 && strcmp(argv[1], "--record") == 0)
+    {
+        recordPath = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+
+    long long ticks = argc > 1 ? atoll(argv[1]) : 10000000;
+    unsigned int seed = argc > 2 ? (unsigned int)atoi(argv[2]) : 1;
+    int count = argc > 3 ? atoi(argv[3]) : 1;
+    int threads = argc > 4 ? atoi(argv[4]) : 0;
+
+    if (count > 1)
+    {
+        runBatch(ticks, seed, count, threads);
+        return 0;
+    }
+
+    GameState state;
+    initGame(state, seed);
+    Replay recording;
+    recording.seed = seed;
+
+    long long games = 0;
+    long long totalScore = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < ticks; i++)
+    {
+        if (state.gameState == 2)
+        {
+            games++;
+            totalScore += state.score;
+        }
+        GameInput input = botInput(state);
+        if (recordPath)
+            recording.inputs.push_back(input.keys);
+        step(state, input);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("ticks: %lld\n", ticks);
+    printf("games: %lld\n", games);
+    printf("average score: %.1f\n", games ? double(totalScore) / games : 0.0);
+    printf("seconds: %.3f\n", seconds);
+    printf("ticks/sec: %.0f\n", ticks / seconds);
+
+    if (recordPath)
+    {
+        recording.finalScore = state.score;
+        recording.finalLives = state.lives;
+        if (!saveReplay(recordPath, recording))
+        {
+            fprintf(stderr, "could not write replay to %s\n", recordPath);
+            return 2;
+        }
+    }
+    return 0;
+}
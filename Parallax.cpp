@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include "glew.h"
+#include "Parallax.h"
+#include "Png.h"
+#include "Simulation.h"
+
+// Pixels per tick at a gameSpeed of 1, back to front: the sky stays put and the ground
+// in front moves a little slower than the obstacles. Layers past the last one use the last speed.
+const float PARALLAX_SPEEDS[] = {0.0f, 0.05f, 0.15f, 0.3f, 0.5f, 0.75f, 1.1f, 1.6f};
+const int PARALLAX_SPEED_COUNT = sizeof(PARALLAX_SPEEDS) / sizeof(PARALLAX_SPEEDS[0]);
+
+struct ParallaxVertex
+{
+    float x, y, u, v;
+};
+
+static GLuint texture = 0;
+static int layerCount = 0;
+static int layerWidth = 0; // every layer, once scaled to WINDOW_HEIGHT
+static std::vector<float> offsets; // per layer, in layer pixels, within [0, layerWidth)
+static float lead = 0; // pixels at a speed of 1 the layers are drawn ahead of their offsets
+static std::vector<int> firstRows, lastRows; // per layer, the rows from the top with anything visible
+static std::vector<ParallaxVertex> vertices;
+
+// Box-filters `source` down (or up) to width x height into `out`. Colors are weighted by alpha,
+// so the transparent pixels around a layer's shapes do not darken their edges.
+static void resample(const std::vector<unsigned char> &source, int sourceWidth, int sourceHeight, unsigned char *out,
+                     int width, int height)
+{
+    float scaleX = float(sourceWidth) / width;
+    float scaleY = float(sourceHeight) / height;
+    for (int y = 0; y < height; y++)
+    {
+        int y0 = int(y * scaleY);
+        int y1 = std::max(y0 + 1, std::min(sourceHeight, int(ceilf((y + 1) * scaleY))));
+        for (int x = 0; x < width; x++)
+        {
+            int x0 = int(x * scaleX);
+            int x1 = std::max(x0 + 1, std::min(sourceWidth, int(ceilf((x + 1) * scaleX))));
+            unsigned long long red = 0, green = 0, blue = 0, alpha = 0, count = 0;
+            for (int sy = y0; sy < y1; sy++)
+            {
+                const unsigned char *pixel = &source[((size_t)sy * sourceWidth + x0) * 4];
+                for (int sx = x0; sx < x1; sx++, pixel += 4)
+                {
+                    red += pixel[0] * pixel[3];
+                    green += pixel[1] * pixel[3];
+                    blue += pixel[2] * pixel[3];
+                    alpha += pixel[3];
+                    count++;
+                }
+            }
+            unsigned char *texel = &out[((size_t)y * width + x) * 4];
+            texel[0] = alpha ? (unsigned char)(red / alpha) : 0;
+            texel[1] = alpha ? (unsigned char)(green / alpha) : 0;
+            texel[2] = alpha ? (unsigned char)(blue / alpha) : 0;
+            texel[3] = (unsigned char)(alpha / count);
+        }
+    }
+}
+
+// Most layers are transparent above their shapes; only the rows between first and last are drawn
+static void findVisibleRows(const unsigned char *layer, int &first, int &last)
+{
+    for (int y = 0; y < WINDOW_HEIGHT; y++)
+    {
+        const unsigned char *row = &layer[(size_t)y * layerWidth * 4];
+        for (int x = 0; x < layerWidth; x++)
+        {
+            if (row[4 * x + 3])
+            {
+                first = std::min(first, y);
+                last = y;
+                break;
+            }
+        }
+    }
+}
+
+bool initParallax(const char *directory, int layers)
+{
+    // Every layer is assumed to have the first one's shape
+    int width, height;
+    std::vector<unsigned char> first;
+    if (!loadPng((std::string(directory) + "/1.png").c_str(), width, height, first))
+        return false;
+    layerWidth = (int)lroundf(float(width) * WINDOW_HEIGHT / height);
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (!GLEW_VERSION_2_0 || layerWidth > maxSize || layers * WINDOW_HEIGHT > maxSize)
+        return false;
+
+    // Layer i fills rows [i * WINDOW_HEIGHT, (i + 1) * WINDOW_HEIGHT) of the atlas, top row first
+    size_t layerBytes = (size_t)layerWidth * WINDOW_HEIGHT * 4;
+    std::vector<unsigned char> atlas(layerBytes * layers);
+    std::vector<char> loaded(layers);
+    firstRows.assign(layers, WINDOW_HEIGHT);
+    lastRows.assign(layers, -1);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < layers; i++)
+    {
+        threads.emplace_back([&, i] {
+            int w = width, h = height;
+            std::vector<unsigned char> pixels;
+            if (i == 0)
+                pixels.swap(first);
+            else if (!loadPng((std::string(directory) + "/" + std::to_string(i + 1) + ".png").c_str(), w, h, pixels))
+                return;
+            resample(pixels, w, h, &atlas[layerBytes * i], layerWidth, WINDOW_HEIGHT);
+            findVisibleRows(&atlas[layerBytes * i], firstRows[i], lastRows[i]);
+            loaded[i] = true;
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    for (int i = 0; i < layers; i++)
+    {
+        if (!loaded[i])
+            return false;
+    }
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, layerWidth, WINDOW_HEIGHT * layers, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 atlas.data());
+    // Layers are drawn texel for pixel, so nothing needs filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    layerCount = layers;
+    offsets.assign(layers, 0.0f);
+    vertices.reserve(layers * 12);
+    return true;
+}
+
+bool parallaxLoaded()
+{
+    return layerCount > 0;
+}
+
+void scrollParallax(float gameSpeed)
+{
+    for (int i = 0; i < layerCount; i++)
+    {
+        float speed = PARALLAX_SPEEDS[std::min(i, PARALLAX_SPEED_COUNT - 1)];
+        offsets[i] = fmodf(offsets[i] + speed * gameSpeed, (float)layerWidth);
+    }
+}
+
+void leadParallax(float gameSpeed, float ticks)
+{
+    lead = gameSpeed * ticks;
+}
+
+// Screen columns [x1, x2) show layer columns from `column` on, over screen rows [y1, y2) of texture rows [v1, v2]
+static void addQuad(float x1, float x2, float column, float y1, float y2, float v1, float v2)
+{
+    float u1 = column / layerWidth;
+    float u2 = (column + x2 - x1) / layerWidth;
+    vertices.push_back({x1, y1, u1, v2});
+    vertices.push_back({x2, y1, u2, v2});
+    vertices.push_back({x2, y2, u2, v1});
+    vertices.push_back({x1, y1, u1, v2});
+    vertices.push_back({x2, y2, u2, v1});
+    vertices.push_back({x1, y2, u1, v1});
+}
+
+void drawParallax()
+{
+    if (!layerCount)
+        return;
+
+    // A layer that wraps inside the window takes a second quad for its start
+    vertices.clear();
+    float atlasHeight = float(WINDOW_HEIGHT * layerCount);
+    for (int i = 0; i < layerCount; i++)
+    {
+        if (lastRows[i] < firstRows[i])
+            continue;
+        float v1 = float(i * WINDOW_HEIGHT + firstRows[i]) / atlasHeight;
+        float v2 = float(i * WINDOW_HEIGHT + lastRows[i] + 1) / atlasHeight;
+        float y1 = float(WINDOW_HEIGHT - 1 - lastRows[i]);
+        float y2 = float(WINDOW_HEIGHT - firstRows[i]);
+
+        // Whole texels, so every pixel samples exactly one
+        float speed = PARALLAX_SPEEDS[std::min(i, PARALLAX_SPEED_COUNT - 1)];
+        float offset = fmodf(offsets[i] + speed * lead, (float)layerWidth);
+        offset = floorf(offset < 0 ? offset + layerWidth : offset);
+        float tail = layerWidth - offset;
+        addQuad(0, std::min(tail, (float)WINDOW_WIDTH), offset, y1, y2, v1, v2);
+        if (tail < WINDOW_WIDTH)
+            addQuad(tail, WINDOW_WIDTH, 0, y1, y2, v1, v2);
+    }
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // Skipping the fully transparent texels saves blending them for nothing
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(ParallaxVertex), &vertices[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(ParallaxVertex), &vertices[0].u);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glDisable(GL_ALPHA_TEST);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
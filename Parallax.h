@@ -0,0 +1,25 @@
+#pragma once
+
+// Scrolling background of layered images, back to front. The layers are scaled to the window height and
+// uploaded once, stacked in one texture. Each frame draws every layer with a single glDrawArrays;
+// scrolling only moves texture coordinates, so the images are never touched again.
+
+// The layers that ship with the game, relative to the working directory
+const char *const DAWN_LAYERS_DIRECTORY = "textures/The Dawn/Layers";
+const int DAWN_LAYERS = 8;
+
+// Loads 1.png, 2.png, ... up to `layers` from `directory`, decoding them in parallel.
+// Needs the GL context and initRenderer(), which loads GLEW. Returns false, and leaves
+// parallaxLoaded() false, if a layer cannot be read or the texture would not fit the GL's limits.
+bool initParallax(const char *directory, int layers);
+bool parallaxLoaded();
+
+// Moves the layers on by one tick at `gameSpeed`; nearer layers move faster
+void scrollParallax(float gameSpeed);
+
+// Draws the layers `ticks` of a tick on from where they have scrolled to, at `gameSpeed`, for frames
+// between two ticks. Negative `ticks` draw them behind; scrollParallax() leaves the lead as it is.
+void leadParallax(float gameSpeed, float ticks);
+
+// Covers the whole window with the layers
+void drawParallax();
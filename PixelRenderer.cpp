@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "PixelRenderer.h"
+
+struct Color
+{
+    float r, g, b;
+};
+
+const Color SKY_COLOR = {0.0f, 0.1f, 0.9f};
+const Color SUN_COLOR = {1.0f, 1.0f, 0.0f};
+const Color CLOUD_COLOR = {1.0f, 1.0f, 1.0f};
+const Color BOUNDARY_COLOR = {0.5f, 0.5f, 0.5f};
+const Color BOUNDARY_DETAIL_COLOR = {0.7f, 0.7f, 0.7f};
+const Color PLAYER_BODY_COLOR = {0.3f, 0.2f, 0.4f};
+const Color PLAYER_HEAD_COLOR = {1.0f, 0.5f, 0.6f};
+const Color PLAYER_EYE_COLOR = {0.0f, 0.0f, 0.0f};
+const Color PLAYER_MOUTH_COLOR = {1.0f, 0.0f, 0.0f};
+const Color OBSTACLE_COLOR = {1.0f, 0.0f, 0.0f};
+const Color OBSTACLE_TIP_COLOR = {0.8f, 0.2f, 0.2f};
+const Color COLLECTABLE_COLOR = {1.0f, 1.0f, 0.0f};
+const Color COLLECTABLE_STAR_COLOR = {1.0f, 0.5f, 0.1f};
+const Color COLLECTABLE_CENTER_COLOR = {1.0f, 0.0f, 0.0f};
+const Color POWERUP1_COLOR = {0.9f, 0.1f, 0.3f};
+const Color POWERUP1_STAR_COLOR = {0.0f, 1.0f, 0.5f};
+const Color POWERUP1_LINE_COLOR = {0.0f, 0.0f, 0.0f};
+const Color POWERUP2_COLOR = {0.0f, 1.0f, 0.0f};
+const Color POWERUP2_CENTER_COLOR = {1.0f, 1.0f, 0.0f};
+
+// Target image; shapes are given in world coordinates (y up) and sampled at pixel centers
+struct Canvas
+{
+    unsigned char *pixels;
+    int width;
+    int height;
+    PixelFormat format;
+};
+
+// Where a shape's local coordinates land in the world
+struct Placement
+{
+    float x, y;
+    float cosAngle, sinAngle;
+};
+
+static Placement place(float x, float y, float degrees = 0)
+{
+    float radians = degrees * 3.14159265f / 180;
+    return {x, y, std::cos(radians), std::sin(radians)};
+}
+
+static void colorBytes(const Canvas &canvas, Color color, unsigned char *bytes)
+{
+    if (canvas.format == PIXELS_GRAY)
+    {
+        bytes[0] = (unsigned char)((0.299f * color.r + 0.587f * color.g + 0.114f * color.b) * 255 + 0.5f);
+        return;
+    }
+    bytes[0] = (unsigned char)(color.r * 255 + 0.5f);
+    bytes[1] = (unsigned char)(color.g * 255 + 0.5f);
+    bytes[2] = (unsigned char)(color.b * 255 + 0.5f);
+}
+
+// World y at the center of a pixel row
+static float rowY(const Canvas &canvas, int row)
+{
+    return WINDOW_HEIGHT - (row + 0.5f) * WINDOW_HEIGHT / canvas.height;
+}
+
+// Fills the pixels of one row whose centers lie in the world x range [x1, x2)
+static void fillSpan(const Canvas &canvas, int row, float x1, float x2, const unsigned char *bytes)
+{
+    float scale = (float)canvas.width / WINDOW_WIDTH;
+    int first = std::max(0, (int)std::ceil(x1 * scale - 0.5f));
+    int last = std::min(canvas.width, (int)std::ceil(x2 * scale - 0.5f));
+    unsigned char *out = canvas.pixels + ((size_t)row * canvas.width + first) * canvas.format;
+    for (int column = first; column < last; column++)
+    {
+        for (int c = 0; c < canvas.format; c++)
+            *out++ = bytes[c];
+    }
+}
+
+// Row range covering world y in [y1, y2]
+static void rowRange(const Canvas &canvas, float y1, float y2, int &first, int &last)
+{
+    float scale = (float)canvas.height / WINDOW_HEIGHT;
+    first = std::max(0, (int)std::floor((WINDOW_HEIGHT - y2) * scale));
+    last = std::min(canvas.height - 1, (int)std::ceil((WINDOW_HEIGHT - y1) * scale));
+}
+
+static void fillRect(const Canvas &canvas, float x1, float y1, float x2, float y2, Color color)
+{
+    unsigned char bytes[3];
+    colorBytes(canvas, color, bytes);
+    int first, last;
+    rowRange(canvas, std::min(y1, y2), std::max(y1, y2), first, last);
+    for (int row = first; row <= last; row++)
+    {
+        float y = rowY(canvas, row);
+        if (y >= std::min(y1, y2) && y < std::max(y1, y2))
+            fillSpan(canvas, row, std::min(x1, x2), std::max(x1, x2), bytes);
+    }
+}
+
+// Convex polygon in local coordinates, moved and rotated by `at`
+static void fillPolygon(const Canvas &canvas, Placement at, const float (*local)[2], int count, Color color)
+{
+    float xs[8], ys[8];
+    float top = -1e9f, bottom = 1e9f;
+    for (int k = 0; k < count; k++)
+    {
+        xs[k] = at.x + local[k][0] * at.cosAngle - local[k][1] * at.sinAngle;
+        ys[k] = at.y + local[k][0] * at.sinAngle + local[k][1] * at.cosAngle;
+        top = std::max(top, ys[k]);
+        bottom = std::min(bottom, ys[k]);
+    }
+
+    unsigned char bytes[3];
+    colorBytes(canvas, color, bytes);
+    int first, last;
+    rowRange(canvas, bottom, top, first, last);
+    for (int row = first; row <= last; row++)
+    {
+        float y = rowY(canvas, row);
+        float left = 1e9f, right = -1e9f;
+        for (int k = 0; k < count; k++)
+        {
+            int n = (k + 1) % count;
+            if ((ys[k] <= y && y < ys[n]) || (ys[n] <= y && y < ys[k]))
+            {
+                float x = xs[k] + (y - ys[k]) * (xs[n] - xs[k]) / (ys[n] - ys[k]);
+                left = std::min(left, x);
+                right = std::max(right, x);
+            }
+        }
+        if (left < right)
+            fillSpan(canvas, row, left, right, bytes);
+    }
+}
+
+static void fillCircle(const Canvas &canvas, float cx, float cy, float r, Color color)
+{
+    unsigned char bytes[3];
+    colorBytes(canvas, color, bytes);
+    int first, last;
+    rowRange(canvas, cy - r, cy + r, first, last);
+    for (int row = first; row <= last; row++)
+    {
+        float dy = rowY(canvas, row) - cy;
+        if (dy * dy < r * r)
+        {
+            float half = std::sqrt(r * r - dy * dy);
+            fillSpan(canvas, row, cx - half, cx + half, bytes);
+        }
+    }
+}
+
+// Same four triangles as drawShuriken()
+static void fillShuriken(const Canvas &canvas, Placement at, float r, Color color)
+{
+    const float points[4][3][2] = {
+        {{0, r}, {-r / 2, 0}, {r / 2, 0}},
+        {{0, -r}, {-r / 2, 0}, {r / 2, 0}},
+        {{r, 0}, {0, -r / 2}, {0, r / 2}},
+        {{-r, 0}, {0, -r / 2}, {0, r / 2}},
+    };
+    for (auto &triangle : points)
+        fillPolygon(canvas, at, triangle, 3, color);
+}
+
+static void fillRegular(const Canvas &canvas, Placement at, int sides, float r, Color color)
+{
+    float points[8][2];
+    for (int i = 0; i < sides; i++)
+    {
+        float theta = 2.0f * 3.14f * float(i) / float(sides);
+        points[i][0] = r * std::cos(theta);
+        points[i][1] = r * std::sin(theta);
+    }
+    fillPolygon(canvas, at, points, sides, color);
+}
+
+// A line one world unit wide from (x1, y1) to (x2, y2), like batchLineStrip()
+static void fillSegment(const Canvas &canvas, float x1, float y1, float x2, float y2, Color color)
+{
+    float length = std::sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+    if (length == 0)
+        return;
+    float nx = (y1 - y2) / length * 0.5f;
+    float ny = (x2 - x1) / length * 0.5f;
+    const float quad[4][2] = {{x1 + nx, y1 + ny}, {x2 + nx, y2 + ny}, {x2 - nx, y2 - ny}, {x1 - nx, y1 - ny}};
+    fillPolygon(canvas, place(0, 0), quad, 4, color);
+}
+
+static void renderBackground(const Canvas &canvas, const GameState &state)
+{
+    fillRect(canvas, 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, SKY_COLOR);
+    fillCircle(canvas, WINDOW_WIDTH - 50, WINDOW_HEIGHT - 150, 25, SUN_COLOR);
+    for (int i = 0; i < 4; i++)
+    {
+        float x = i * 200 - state.backgroundX;
+        float y = WINDOW_HEIGHT - 100 * i - 90;
+        fillRect(canvas, x, y - 50, x + 100, y, CLOUD_COLOR);
+    }
+}
+
+static void renderBoundaries(const Canvas &canvas)
+{
+    const float ground = PLAYER_BASE_Y - PLAYER_SIZE / 2;
+    fillRect(canvas, 0, WINDOW_HEIGHT - 55, WINDOW_WIDTH, WINDOW_HEIGHT, BOUNDARY_COLOR);
+    fillRect(canvas, 0, 0, WINDOW_WIDTH, ground, BOUNDARY_COLOR);
+
+    for (int i = 0; i < WINDOW_WIDTH; i += 111)
+    {
+        const float spike[3][2] = {{0, 0}, {55, 0}, {25, 30}};
+        fillPolygon(canvas, place(i, WINDOW_HEIGHT - 55), spike, 3, BOUNDARY_DETAIL_COLOR);
+    }
+    for (int i = 0; i < 3; i++)
+        fillRect(canvas, 0, ground - 40 * i, WINDOW_WIDTH, ground - 40 * i - 20, BOUNDARY_DETAIL_COLOR);
+}
+
+static void renderPlayer(const Canvas &canvas, const GameState &state)
+{
+    fillRegular(canvas, place(PLAYER_BASE_X, state.playerY), 6, PLAYER_SIZE / 2, PLAYER_BODY_COLOR);
+    fillRegular(canvas, place(PLAYER_BASE_X, state.playerY + PLAYER_SIZE / 2), 5, PLAYER_HEAD_SIZE / 2, PLAYER_HEAD_COLOR);
+
+    const float h = PLAYER_HEAD_SIZE, top = PLAYER_SIZE / 2;
+    const float leftEye[3][2] = {{-h / 4, top + h / 4}, {-h / 6, top + h / 6}, {-h / 4, top + h / 6}};
+    const float rightEye[3][2] = {{h / 4, top + h / 4}, {h / 6, top + h / 6}, {h / 4, top + h / 6}};
+    fillPolygon(canvas, place(PLAYER_BASE_X, state.playerY), leftEye, 3, PLAYER_EYE_COLOR);
+    fillPolygon(canvas, place(PLAYER_BASE_X, state.playerY), rightEye, 3, PLAYER_EYE_COLOR);
+
+    // Mouth: the same half-circle arc of 180 segments as drawPlayer()
+    float mouthY = state.playerY + top - h / 4;
+    for (int i = 0; i < 180; i++)
+    {
+        float theta1 = 3.14f * float(i) / 180, theta2 = 3.14f * float(i + 1) / 180;
+        fillSegment(canvas, PLAYER_BASE_X + h / 4 * std::cos(theta1), mouthY + h / 8 * std::sin(theta1),
+                    PLAYER_BASE_X + h / 4 * std::cos(theta2), mouthY + h / 8 * std::sin(theta2), PLAYER_MOUTH_COLOR);
+    }
+}
+
+static void renderEntity(const Canvas &canvas, const GameState &state, int kind, float x, float y)
+{
+    switch (kind)
+    {
+    case ENTITY_OBSTACLE:
+    {
+        const float tip[3][2] = {{OBSTACLE_SIZE / 2, -OBSTACLE_SIZE / 2}, {OBSTACLE_SIZE / 2, OBSTACLE_SIZE / 2}, {OBSTACLE_SIZE, 0}};
+        fillRect(canvas, x - OBSTACLE_SIZE / 2, y - OBSTACLE_SIZE / 2, x + OBSTACLE_SIZE / 2, y + OBSTACLE_SIZE / 2, OBSTACLE_COLOR);
+        fillPolygon(canvas, place(x, y), tip, 3, OBSTACLE_TIP_COLOR);
+        break;
+    }
+    case ENTITY_COLLECTABLE:
+        fillCircle(canvas, x, y, COLLECTABLE_SIZE / 2, COLLECTABLE_COLOR);
+        fillShuriken(canvas, place(x, y, state.collectableAngle), COLLECTABLE_SIZE / 2, COLLECTABLE_STAR_COLOR);
+        // The 5-unit center dot does not turn with the rest
+        fillRect(canvas, x - 2.5f, y - 2.5f, x + 2.5f, y + 2.5f, COLLECTABLE_CENTER_COLOR);
+        break;
+    case ENTITY_POWERUP1:
+    {
+        const float half = POWERUP_SIZE / 2;
+        const float square[4][2] = {{half, half}, {-half, half}, {-half, -half}, {half, -half}};
+        fillPolygon(canvas, place(x, y, 45), square, 4, POWERUP1_COLOR);
+        fillShuriken(canvas, place(x, y), half, POWERUP1_STAR_COLOR);
+        fillSegment(canvas, x - half, y, x + half, y, POWERUP1_LINE_COLOR);
+        fillSegment(canvas, x, y + half, x, y - half, POWERUP1_LINE_COLOR);
+        break;
+    }
+    case ENTITY_POWERUP2:
+        fillShuriken(canvas, place(x, y), POWERUP_SIZE / 2, POWERUP2_COLOR);
+        fillShuriken(canvas, place(x, y, 45), POWERUP_SIZE / 2, POWERUP2_COLOR);
+        fillCircle(canvas, x, y, POWERUP_SIZE / 6, POWERUP2_CENTER_COLOR);
+        break;
+    }
+}
+
+void renderGame(const GameState &state, unsigned char *pixels, int width, int height, PixelFormat format)
+{
+    Canvas canvas = {pixels, width, height, format};
+    renderBackground(canvas, state);
+    if (state.gameState != 1)
+        return;
+
+    renderPlayer(canvas, state);
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        for (auto &entity : state.entities[kind])
+        {
+            if (entity.active)
+                renderEntity(canvas, state, kind, entity.x, entity.y);
+        }
+    }
+    renderBoundaries(canvas);
+}
+
+static void renderRange(const BatchState &batch, unsigned char *pixels, int width, int height, PixelFormat format,
+                        int begin, int end)
+{
+    size_t imageSize = (size_t)width * height * format;
+    GameState state;
+    for (int i = begin; i < end; i++)
+    {
+        loadBatchGame(batch, i, state);
+        renderGame(state, pixels + i * imageSize, width, height, format);
+    }
+}
+
+void renderBatch(const BatchState &batch, unsigned char *pixels, int width, int height, PixelFormat format, int threads)
+{
+    if (threads <= 0)
+        threads = (int)std::thread::hardware_concurrency();
+    threads = std::max(1, std::min(threads, batch.count));
+
+    // Every image costs about the same, so equal shares keep the threads busy
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++)
+    {
+        int begin = (int)((long long)batch.count * t / threads);
+        int end = (int)((long long)batch.count * (t + 1) / threads);
+        workers.emplace_back(renderRange, std::cref(batch), pixels, width, height, format, begin, end);
+    }
+    renderRange(batch, pixels, width, height, format, 0, batch.count / threads);
+    for (auto &worker : workers)
+        worker.join();
+}
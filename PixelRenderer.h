@@ -0,0 +1,23 @@
+#pragma once
+
+#include "BatchSimulation.h"
+#include "Simulation.h"
+
+// Software rendering of the play screen for agents that learn from pixels, no GL context needed.
+// Draws what display() draws while playing: sky, sun, clouds, boundaries, player and entities.
+// Text and the health hearts are left out; they are unreadable at observation sizes.
+// The shapes are a copy of Draw.cpp's, drawn without its command recorder; Bench --check-software
+// compares the two.
+enum PixelFormat
+{
+    PIXELS_GRAY = 1, // one byte per pixel
+    PIXELS_RGB = 3   // three bytes per pixel
+};
+
+// Renders one game into width * height * format bytes, top row first.
+// Any size works; 84x84 and 128x96 are the usual ones.
+void renderGame(const GameState &, unsigned char *pixels, int width, int height, PixelFormat);
+
+// Renders every game of a batch, image i at pixels + i * width * height * format,
+// split over `threads` threads (0: one per core)
+void renderBatch(const BatchState &, unsigned char *pixels, int width, int height, PixelFormat, int threads);
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Planner.h"
+
+enum PlanAction
+{
+    PLAN_IDLE,
+    PLAN_JUMP,
+    PLAN_DUCK,
+    PLAN_ACTIONS
+};
+
+struct PlanNode
+{
+    GameState state;
+    PlanAction first; // the action this sequence starts with, the one that gets played
+    double value;
+};
+
+// Keys that start `action` from `state`. step() handles JUMP before DUCK_UP, so a jump can not
+// leave a duck in one tick: the first tick only stands up and followInput() jumps on the next.
+static GameInput actionInput(const GameState &state, PlanAction action)
+{
+    GameInput input = {0};
+    if (action == PLAN_DUCK)
+    {
+        if (!state.isDucking)
+            input.keys = INPUT_DUCK;
+        return input;
+    }
+    if (state.isDucking)
+        input.keys = INPUT_DUCK_UP;
+    else if (action == PLAN_JUMP)
+        input.keys = INPUT_JUMP;
+    return input;
+}
+
+// Keys for the second tick of `action`; the rest of its ticks send nothing
+static GameInput followInput(const GameState &state, PlanAction action)
+{
+    GameInput input = {0};
+    if (action == PLAN_JUMP && !state.isJumping)
+        input.keys = INPUT_JUMP;
+    return input;
+}
+
+// Lives dominate, then score; running out of lives is worst of all
+static double evaluate(const GameState &state)
+{
+    if (state.gameState == 2 && state.lives <= 0)
+        return -1e9 + state.score;
+    return state.lives * 1e6 + state.score;
+}
+
+static void expandRange(const std::vector<PlanNode> &beam, std::vector<PlanNode> &children, int ticks, int begin, int end)
+{
+    for (int c = begin; c < end; c++)
+    {
+        const PlanNode &parent = beam[c / PLAN_ACTIONS];
+        PlanAction action = PlanAction(c % PLAN_ACTIONS);
+        PlanNode &child = children[c];
+        child.state = parent.state;
+        child.first = parent.first;
+        step(child.state, actionInput(child.state, action));
+        for (int t = 1; t < ticks && child.state.gameState == 1; t++)
+            step(child.state, t == 1 ? followInput(child.state, action) : GameInput{0});
+        child.value = evaluate(child.state);
+    }
+}
+
+// Helper threads for expand(), kept from one call to the next: starting and joining threads at every
+// level of every tick cost more than the rollouts they ran. Each thread that plans gets its own pool,
+// so planners on different threads never wait for each other.
+struct ExpandPool
+{
+    std::mutex lock;
+    std::condition_variable wake, done;
+    std::vector<std::thread> helpers;
+    unsigned long long generation = 0; // bumped for every expansion
+    int pending = 0;                   // helpers still running the current one
+    bool stopping = false;
+
+    // The current expansion; helper i takes the i-th of `threads` shares, the caller the 0th
+    const std::vector<PlanNode> *beam = nullptr;
+    std::vector<PlanNode> *children = nullptr;
+    int ticks = 0, count = 0, threads = 1;
+
+    ~ExpandPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &helper : helpers)
+            helper.join();
+    }
+
+    void work(int index, unsigned long long seen)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        for (;;)
+        {
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            if (index >= threads)
+                continue;
+            guard.unlock();
+            expandRange(*beam, *children, ticks, count * index / threads, count * (index + 1) / threads);
+            guard.lock();
+            if (--pending == 0)
+                done.notify_one();
+        }
+    }
+
+    void expand(const std::vector<PlanNode> &nodes, std::vector<PlanNode> &out, int steps, int shares)
+    {
+        // Only this thread bumps the generation, so new helpers can be told the current one unlocked
+        while ((int)helpers.size() < shares - 1)
+            helpers.emplace_back(&ExpandPool::work, this, (int)helpers.size() + 1, generation);
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            beam = &nodes;
+            children = &out;
+            ticks = steps;
+            count = (int)nodes.size() * PLAN_ACTIONS;
+            threads = shares;
+            pending = shares - 1;
+            generation++;
+        }
+        wake.notify_all();
+        expandRange(nodes, out, steps, 0, count / shares);
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&] { return pending == 0; });
+    }
+};
+
+static void expand(const std::vector<PlanNode> &beam, std::vector<PlanNode> &children, int ticks, int threads)
+{
+    int count = (int)beam.size() * PLAN_ACTIONS;
+    children.resize(count);
+    threads = std::max(1, std::min(threads, count));
+    if (threads == 1)
+    {
+        expandRange(beam, children, ticks, 0, count);
+        return;
+    }
+    static thread_local ExpandPool pool;
+    pool.expand(beam, children, ticks, threads);
+}
+
+static void fillStats(PlannerStats *stats, int depth, std::chrono::steady_clock::time_point start)
+{
+    if (!stats)
+        return;
+    stats->depth = depth;
+    stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+GameInput planAction(const GameState &state, const PlannerConfig &config, PlannerStats *stats)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (state.gameState != 1)
+    {
+        GameInput input = {(unsigned char)(state.gameState == 0 ? INPUT_START : INPUT_RESTART)};
+        fillStats(stats, 0, start);
+        return input;
+    }
+
+    // The first level fixes which action each sequence starts with; it always runs so there is something to play
+    std::vector<PlanNode> beam(1);
+    beam[0].state = state;
+    std::vector<PlanNode> children;
+    int repeat = std::max(1, config.actionRepeat);
+    expand(beam, children, repeat, config.threads);
+    for (int c = 0; c < (int)children.size(); c++)
+        children[c].first = PlanAction(c);
+    int depth = repeat;
+
+    // Deeper levels only start if, at the last level's cost per rollout, they would finish within the budget
+    auto levelStart = start;
+    auto better = [](const PlanNode &a, const PlanNode &b) { return a.value > b.value; };
+    for (;;)
+    {
+        auto now = std::chrono::steady_clock::now();
+        double perRollout = std::chrono::duration<double>(now - levelStart).count() / children.size();
+        std::stable_sort(children.begin(), children.end(), better);
+        if ((int)children.size() > config.beamWidth)
+            children.resize(std::max(1, config.beamWidth));
+        beam.swap(children);
+
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        double next = perRollout * beam.size() * PLAN_ACTIONS;
+        if (depth + repeat > config.horizon || elapsed + next > config.budgetSeconds)
+            break;
+        levelStart = now;
+        expand(beam, children, repeat, config.threads);
+        depth += repeat;
+    }
+
+    fillStats(stats, depth, start);
+    return actionInput(state, beam[0].first);
+}
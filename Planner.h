@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Simulation.h"
+
+// Beam search over idle/jump/duck sequences, run on copies of the game state.
+// The copies carry the random stream, so the planner sees exactly what will spawn;
+// that makes it an upper-bound baseline and a playtester for the speed ramp, not a fair player.
+struct PlannerConfig
+{
+    int horizon;          // ticks looked ahead
+    int actionRepeat;     // ticks each planned action is held, so the tree branches every actionRepeat ticks
+    int beamWidth;        // sequences kept after each expansion
+    double budgetSeconds; // the search stops deepening once a decision has used this much time
+    int threads;          // rollouts of one expansion are split over this many threads, kept between calls
+};
+
+const PlannerConfig DEFAULT_PLANNER_CONFIG = {90, 6, 32, 0.010, 1};
+
+struct PlannerStats
+{
+    int depth;   // ticks actually searched before the budget ran out; 0 when not playing
+    double seconds;
+};
+
+// Picks the keys for the next tick; also starts or restarts the game when it is not being played
+GameInput planAction(const GameState &, const PlannerConfig &, PlannerStats *stats = nullptr);
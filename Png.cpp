@@ -0,0 +1,390 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "Png.h"
+
+// Inflate (RFC 1951) over the concatenated IDAT data, after its two-byte zlib header.
+// Huffman codes are decoded canonically a bit at a time, as in zlib's puff.
+const int MAX_CODE_BITS = 15;
+
+struct Huffman
+{
+    short counts[MAX_CODE_BITS + 1]; // codes of each length
+    short symbols[288];              // in canonical order
+};
+
+struct Inflater
+{
+    const unsigned char *in;
+    size_t size, position;
+    unsigned bitBuffer;
+    int bitCount;
+    std::vector<unsigned char> &out;
+    size_t limit; // most bytes `out` may grow to; more means a damaged or hostile stream
+    bool failed;
+
+    Inflater(const unsigned char *in, size_t size, std::vector<unsigned char> &out, size_t limit)
+        : in(in), size(size), position(0), bitBuffer(0), bitCount(0), out(out), limit(limit), failed(false)
+    {
+    }
+
+    int bits(int need)
+    {
+        unsigned value = bitBuffer;
+        while (bitCount < need)
+        {
+            if (position == size)
+            {
+                failed = true;
+                return 0;
+            }
+            value |= (unsigned)in[position++] << bitCount;
+            bitCount += 8;
+        }
+        bitBuffer = value >> need;
+        bitCount -= need;
+        return (int)(value & ((1u << need) - 1));
+    }
+
+    int decode(const Huffman &h)
+    {
+        int code = 0, first = 0, index = 0;
+        for (int length = 1; length <= MAX_CODE_BITS; length++)
+        {
+            code |= bits(1);
+            int count = h.counts[length];
+            if (code - count < first)
+                return h.symbols[index + (code - first)];
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        failed = true;
+        return 0;
+    }
+};
+
+// Returns false if the lengths over-subscribe the code
+static bool buildHuffman(Huffman &h, const short *lengths, int n)
+{
+    memset(h.counts, 0, sizeof(h.counts));
+    for (int s = 0; s < n; s++)
+        h.counts[lengths[s]]++;
+    if (h.counts[0] == n)
+        return true;
+
+    int left = 1;
+    for (int length = 1; length <= MAX_CODE_BITS; length++)
+    {
+        left = (left << 1) - h.counts[length];
+        if (left < 0)
+            return false;
+    }
+
+    short offsets[MAX_CODE_BITS + 1];
+    offsets[1] = 0;
+    for (int length = 1; length < MAX_CODE_BITS; length++)
+        offsets[length + 1] = offsets[length] + h.counts[length];
+    for (int s = 0; s < n; s++)
+    {
+        if (lengths[s])
+            h.symbols[offsets[lengths[s]]++] = (short)s;
+    }
+    return true;
+}
+
+static const short LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                      31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const short LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                       2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const short DISTANCE_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const short DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                         6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static bool inflateCodes(Inflater &z, const Huffman &lengths, const Huffman &distances)
+{
+    for (;;)
+    {
+        int symbol = z.decode(lengths);
+        if (z.failed)
+            return false;
+        if (symbol < 256)
+        {
+            if (z.out.size() >= z.limit)
+                return false;
+            z.out.push_back((unsigned char)symbol);
+        }
+        else if (symbol == 256)
+        {
+            return true;
+        }
+        else
+        {
+            symbol -= 257;
+            if (symbol >= 29)
+                return false;
+            int length = LENGTH_BASE[symbol] + z.bits(LENGTH_EXTRA[symbol]);
+            int d = z.decode(distances);
+            if (z.failed || d >= 30)
+                return false;
+            size_t distance = DISTANCE_BASE[d] + z.bits(DISTANCE_EXTRA[d]);
+            if (z.failed || distance > z.out.size() || z.out.size() + length > z.limit)
+                return false;
+            // Byte by byte, since a match may overlap what it is copying
+            size_t from = z.out.size() - distance;
+            for (int i = 0; i < length; i++)
+                z.out.push_back(z.out[from + i]);
+        }
+    }
+}
+
+static bool inflateStored(Inflater &z)
+{
+    z.bitBuffer = 0;
+    z.bitCount = 0;
+    if (z.position + 4 > z.size)
+        return false;
+    unsigned length = z.in[z.position] | z.in[z.position + 1] << 8;
+    unsigned complement = z.in[z.position + 2] | z.in[z.position + 3] << 8;
+    z.position += 4;
+    if (length != (~complement & 0xffff) || z.position + length > z.size || z.out.size() + length > z.limit)
+        return false;
+    z.out.insert(z.out.end(), z.in + z.position, z.in + z.position + length);
+    z.position += length;
+    return true;
+}
+
+// The fixed codes of RFC 1951 3.2.6
+struct FixedCodes
+{
+    Huffman lengths, distances;
+
+    FixedCodes()
+    {
+        short l[288];
+        for (int s = 0; s < 288; s++)
+            l[s] = s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8;
+        buildHuffman(lengths, l, 288);
+        short d[30];
+        for (int s = 0; s < 30; s++)
+            d[s] = 5;
+        buildHuffman(distances, d, 30);
+    }
+};
+
+static bool inflateFixed(Inflater &z)
+{
+    // Images decode on several threads at once; a local static is built exactly once, thread-safely
+    static const FixedCodes codes;
+    return inflateCodes(z, codes.lengths, codes.distances);
+}
+
+static bool inflateDynamic(Inflater &z)
+{
+    static const short ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    int literalCount = z.bits(5) + 257;
+    int distanceCount = z.bits(5) + 1;
+    int codeCount = z.bits(4) + 4;
+    if (z.failed || literalCount > 286 || distanceCount > 30)
+        return false;
+
+    short l[288 + 30] = {};
+    for (int i = 0; i < codeCount; i++)
+        l[ORDER[i]] = (short)z.bits(3);
+    Huffman codeLengths;
+    if (z.failed || !buildHuffman(codeLengths, l, 19))
+        return false;
+
+    // Literal/length and distance code lengths, run-length coded as one sequence
+    int n = 0;
+    while (n < literalCount + distanceCount)
+    {
+        int symbol = z.decode(codeLengths);
+        if (z.failed)
+            return false;
+        if (symbol < 16)
+        {
+            l[n++] = (short)symbol;
+            continue;
+        }
+        short repeated = 0;
+        int times;
+        if (symbol == 16)
+        {
+            if (n == 0)
+                return false;
+            repeated = l[n - 1];
+            times = 3 + z.bits(2);
+        }
+        else if (symbol == 17)
+        {
+            times = 3 + z.bits(3);
+        }
+        else
+        {
+            times = 11 + z.bits(7);
+        }
+        if (z.failed || n + times > literalCount + distanceCount)
+            return false;
+        while (times--)
+            l[n++] = repeated;
+    }
+
+    Huffman lengths, distances;
+    if (!buildHuffman(lengths, l, literalCount) || !buildHuffman(distances, l + literalCount, distanceCount))
+        return false;
+    return inflateCodes(z, lengths, distances);
+}
+
+// Fails rather than write more than `limit` bytes to `out`
+static bool inflateZlib(const std::vector<unsigned char> &in, std::vector<unsigned char> &out, size_t limit)
+{
+    // CMF must say deflate, and the header must check out; no preset dictionary
+    if (in.size() < 2 || (in[0] & 0x0f) != 8 || (in[0] << 8 | in[1]) % 31 || (in[1] & 0x20))
+        return false;
+
+    Inflater z(in.data() + 2, in.size() - 2, out, limit);
+    int last;
+    do
+    {
+        last = z.bits(1);
+        int type = z.bits(2);
+        if (z.failed)
+            return false;
+        bool ok = type == 0 ? inflateStored(z) : type == 1 ? inflateFixed(z) : type == 2 ? inflateDynamic(z) : false;
+        if (!ok)
+            return false;
+    } while (!last);
+    return true;
+}
+
+// Far beyond any image the game ships; keeps a damaged header from asking for gigabytes
+const int MAX_PNG_SIDE = 16384;
+const long long MAX_PNG_PIXELS = 1 << 26;
+
+static unsigned readBigEndian(const unsigned char *p)
+{
+    return (unsigned)p[0] << 24 | (unsigned)p[1] << 16 | (unsigned)p[2] << 8 | p[3];
+}
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc)
+        return a;
+    return pb <= pc ? b : c;
+}
+
+bool loadPng(const char *path, int &width, int &height, std::vector<unsigned char> &pixels)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    std::vector<unsigned char> data;
+    unsigned char chunk[1 << 16];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + read);
+    fclose(file);
+
+    static const unsigned char SIGNATURE[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    if (data.size() < 8 || memcmp(data.data(), SIGNATURE, 8))
+        return false;
+
+    // Chunks: length, type, data, CRC. The CRCs are not checked.
+    int channels = 0;
+    std::vector<unsigned char> compressed;
+    size_t position = 8;
+    while (position + 12 <= data.size())
+    {
+        size_t length = readBigEndian(&data[position]);
+        const unsigned char *type = &data[position + 4];
+        const unsigned char *body = &data[position + 8];
+        if (length > data.size() - position - 12)
+            return false;
+
+        if (!memcmp(type, "IHDR", 4))
+        {
+            if (length < 13)
+                return false;
+            unsigned w = readBigEndian(body), h = readBigEndian(body + 4);
+            if (w == 0 || h == 0 || w > MAX_PNG_SIDE || h > MAX_PNG_SIDE || (long long)w * h > MAX_PNG_PIXELS)
+                return false;
+            width = (int)w;
+            height = (int)h;
+            int depth = body[8], colorType = body[9], interlace = body[12];
+            if (depth != 8 || (colorType != 2 && colorType != 6) || interlace)
+                return false;
+            channels = colorType == 6 ? 4 : 3;
+        }
+        else if (!memcmp(type, "IDAT", 4))
+        {
+            compressed.insert(compressed.end(), body, body + length);
+        }
+        else if (!memcmp(type, "IEND", 4))
+        {
+            break;
+        }
+        position += length + 12;
+    }
+    if (!channels)
+        return false;
+
+    // Every row is one filter byte followed by its pixels
+    size_t stride = (size_t)width * channels;
+    size_t expected = (stride + 1) * height;
+    std::vector<unsigned char> filtered;
+    filtered.reserve(expected);
+    if (!inflateZlib(compressed, filtered, expected) || filtered.size() < expected)
+        return false;
+
+    // Undo each row's filter in place, against the row above it
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char *row = &filtered[y * (stride + 1) + 1];
+        const unsigned char *above = y ? row - (stride + 1) : nullptr;
+        int filter = row[-1];
+        for (size_t i = 0; i < stride; i++)
+        {
+            int a = i >= (size_t)channels ? row[i - channels] : 0;
+            int b = above ? above[i] : 0;
+            int c = above && i >= (size_t)channels ? above[i - channels] : 0;
+            switch (filter)
+            {
+            case 0:
+                break;
+            case 1:
+                row[i] = (unsigned char)(row[i] + a);
+                break;
+            case 2:
+                row[i] = (unsigned char)(row[i] + b);
+                break;
+            case 3:
+                row[i] = (unsigned char)(row[i] + (a + b) / 2);
+                break;
+            case 4:
+                row[i] = (unsigned char)(row[i] + paeth(a, b, c));
+                break;
+            default:
+                return false;
+            }
+        }
+    }
+
+    pixels.resize((size_t)width * height * 4);
+    for (int y = 0; y < height; y++)
+    {
+        const unsigned char *row = &filtered[y * (stride + 1) + 1];
+        unsigned char *out = &pixels[(size_t)y * width * 4];
+        for (int x = 0; x < width; x++)
+        {
+            out[4 * x] = row[channels * x];
+            out[4 * x + 1] = row[channels * x + 1];
+            out[4 * x + 2] = row[channels * x + 2];
+            out[4 * x + 3] = channels == 4 ? row[channels * x + 3] : 255;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <vector>
+
+// Reads the PNGs the game ships: 8 bits per channel, RGB or RGBA, not interlaced.
+// Pixels come out as RGBA rows from the top of the image down; RGB images get an alpha of 255.
+// Returns false for anything else, for images over 16384 pixels on a side or 2^26 pixels in all,
+// and for files that are missing or damaged.
+bool loadPng(const char *path, int &width, int &height, std::vector<unsigned char> &pixels);
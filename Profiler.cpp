@@ -0,0 +1,162 @@
+#include "Profiler.h"
+
+std::atomic<bool> profilerEnabled(false);
+
+// HDR-style log-linear buckets: values below 16 ns get a bucket each, then every power of two
+// is split into 16 equal buckets. Values are clamped below 2^40 ns, about 18 minutes.
+const int SUB_BUCKET_BITS = 4;
+const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+const int MAX_VALUE_BITS = 40;
+const int HISTOGRAM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+static int bucketOf(unsigned long long value)
+{
+    if (value >= 1ull << MAX_VALUE_BITS)
+        value = (1ull << MAX_VALUE_BITS) - 1;
+    if (value < SUB_BUCKETS)
+        return (int)value;
+    int bits = 0;
+    while (value >> (bits + 1))
+        bits++;
+    int shift = bits - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + (int)((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+// Largest value that lands in `bucket`
+static long long bucketTop(int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+    int shift = bucket / SUB_BUCKETS - 1;
+    long long low = (long long)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+    return low + (1ll << shift) - 1;
+}
+
+// One thread's histograms. Only the thread that holds a block writes to it, with relaxed
+// load-and-store pairs; readers see each counter either before or after an update.
+// Blocks are never freed: a thread that exits hands its block, counts and all, to the next new thread.
+struct ThreadHistograms
+{
+    std::atomic<unsigned long long> counts[PROFILE_PHASES][HISTOGRAM_BUCKETS];
+    std::atomic<long long> max[PROFILE_PHASES];
+    std::atomic<bool> held;
+    ThreadHistograms *next;
+};
+
+static std::atomic<ThreadHistograms *> allHistograms(nullptr);
+
+static ThreadHistograms *claimHistograms()
+{
+    for (ThreadHistograms *block = allHistograms.load(std::memory_order_acquire); block; block = block->next)
+    {
+        bool expected = false;
+        if (!block->held.load(std::memory_order_relaxed) && block->held.compare_exchange_strong(expected, true))
+            return block;
+    }
+
+    ThreadHistograms *block = new ThreadHistograms();
+    block->held.store(true, std::memory_order_relaxed);
+    block->next = allHistograms.load(std::memory_order_relaxed);
+    while (!allHistograms.compare_exchange_weak(block->next, block, std::memory_order_release))
+    {
+    }
+    return block;
+}
+
+// Claims a block on the thread's first recording and releases it when the thread exits
+struct HistogramHandle
+{
+    ThreadHistograms *block = nullptr;
+
+    ~HistogramHandle()
+    {
+        if (block)
+            block->held.store(false, std::memory_order_release);
+    }
+};
+
+static thread_local HistogramHandle threadHistograms;
+
+void recordPhase(ProfilePhase phase, long long nanoseconds)
+{
+    if (!threadHistograms.block)
+        threadHistograms.block = claimHistograms();
+    ThreadHistograms &histograms = *threadHistograms.block;
+
+    auto &count = histograms.counts[phase][bucketOf(nanoseconds > 0 ? nanoseconds : 0)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (nanoseconds > histograms.max[phase].load(std::memory_order_relaxed))
+        histograms.max[phase].store(nanoseconds, std::memory_order_relaxed);
+}
+
+void endPhase(ProfilePhase phase, long long start, long long end)
+{
+    if (profilerEnabled.load(std::memory_order_relaxed))
+        recordPhase(phase, end - start);
+    if (traceEnabled.load(std::memory_order_relaxed))
+        traceEvent(phaseName(phase), start, end);
+}
+
+PhaseSummary summarizePhase(ProfilePhase phase)
+{
+    unsigned long long merged[HISTOGRAM_BUCKETS] = {};
+    PhaseSummary summary = {0, 0, 0, 0};
+
+    for (ThreadHistograms *block = allHistograms.load(std::memory_order_acquire); block; block = block->next)
+    {
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+            merged[b] += block->counts[phase][b].load(std::memory_order_relaxed);
+        long long max = block->max[phase].load(std::memory_order_relaxed);
+        if (max > summary.max)
+            summary.max = max;
+    }
+
+    for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+        summary.count += merged[b];
+
+    // The smallest bucket tops that cover half and 99% of the samples
+    long long seen = 0;
+    bool halfSeen = false;
+    for (int b = 0; b < HISTOGRAM_BUCKETS && summary.count; b++)
+    {
+        seen += merged[b];
+        if (!halfSeen && seen * 2 >= summary.count)
+        {
+            summary.p50 = bucketTop(b);
+            halfSeen = true;
+        }
+        if (seen * 100 >= summary.count * 99)
+        {
+            summary.p99 = bucketTop(b);
+            break;
+        }
+    }
+    if (summary.p50 > summary.max)
+        summary.p50 = summary.max;
+    if (summary.p99 > summary.max)
+        summary.p99 = summary.max;
+    return summary;
+}
+
+const char *phaseName(ProfilePhase phase)
+{
+    static const char *const NAMES[PROFILE_PHASES] = {
+        "timers", "player", "obstacles", "collectables", "powerups1", "powerups2", "spawn",
+        "compact", "tick", "background", "entities", "boundaries", "hud", "submit",
+        "text", "frame",
+    };
+    return NAMES[phase];
+}
+
+void printProfile(FILE *out)
+{
+    fprintf(out, "%-12s %10s %10s %10s %10s\n", "phase", "count", "p50 us", "p99 us", "max us");
+    for (int p = 0; p < PROFILE_PHASES; p++)
+    {
+        PhaseSummary summary = summarizePhase(ProfilePhase(p));
+        if (!summary.count)
+            continue;
+        fprintf(out, "%-12s %10lld %10.2f %10.2f %10.2f\n", phaseName(ProfilePhase(p)), summary.count,
+                summary.p50 / 1000.0, summary.p99 / 1000.0, summary.max / 1000.0);
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include "Trace.h"
+
+// Parts of a tick and a frame that the profiler times.
+// Draw phases up to hud mostly fill the batch; submit is where its GL calls are made,
+// except that instanced entities draw the batch so far and themselves within entities,
+// and a HUD layer that is out of date is redrawn within hud.
+// Work the driver defers past that lands in frame, which ends with the flush.
+enum ProfilePhase
+{
+    PHASE_TIMERS,      // step(): timers, powerups and game speed
+    PHASE_PLAYER,      // step(): player physics
+    PHASE_OBSTACLES,   // step(): one entity loop per EntityKind, in EntityKind order
+    PHASE_COLLECTABLES,
+    PHASE_POWERUPS1,
+    PHASE_POWERUPS2,
+    PHASE_SPAWN,       // step(): spawning
+    PHASE_COMPACT,     // step(): removing inactive entities
+    PHASE_TICK,        // a whole step() on the simulation thread
+    PHASE_BACKGROUND,  // drawFrame(): clear and the parallax layers, or sky, sun and clouds without them
+    PHASE_ENTITIES,    // drawFrame(): player and entities
+    PHASE_BOUNDARIES,  // drawFrame(): boundaries
+    PHASE_HUD,         // drawFrame(): health, or redrawing the HUD layer when it is out of date
+    PHASE_SUBMIT,      // drawFrame(): uploading and drawing the batch, and copying the HUD layer
+    PHASE_TEXT,        // drawFrame(): laying out and drawing score, time, powerups, start and game over text
+    PHASE_FRAME,       // a whole display(), flush included
+    PROFILE_PHASES
+};
+
+// Off by default; when off, every timing point costs one branch
+extern std::atomic<bool> profilerEnabled;
+
+inline long long profileNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Adds one duration to the calling thread's histogram for `phase`.
+// Every thread writes only its own histograms, so recording takes no lock and no read-modify-write.
+void recordPhase(ProfilePhase, long long nanoseconds);
+
+// Records a finished phase into the histograms and/or the trace, whichever are on
+void endPhase(ProfilePhase, long long start, long long end);
+
+// Times consecutive phases of one function: each lap() records the time since the previous lap.
+// Phases also show up as trace events while tracing.
+struct PhaseTimer
+{
+    bool enabled;
+    long long last;
+
+    PhaseTimer()
+        : enabled(profilerEnabled.load(std::memory_order_relaxed) || traceEnabled.load(std::memory_order_relaxed)),
+          last(enabled ? profileNow() : 0)
+    {
+    }
+
+    void lap(ProfilePhase phase)
+    {
+        if (enabled)
+        {
+            long long now = profileNow();
+            endPhase(phase, last, now);
+            last = now;
+        }
+    }
+};
+
+struct PhaseSummary
+{
+    long long count;
+    long long p50, p99, max; // nanoseconds; percentiles are within 1/16 of the true value
+};
+
+// Merges every thread's histograms; safe to call while other threads keep recording
+PhaseSummary summarizePhase(ProfilePhase);
+
+const char *phaseName(ProfilePhase);
+
+// Prints count, p50, p99 and max of every phase that has been recorded
+void printProfile(FILE *);
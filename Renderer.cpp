@@ -0,0 +1,666 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "glew.h"
+#include "Renderer.h"
+
+#ifdef _WIN32
+#pragma comment(lib, "glew32.lib")
+#endif
+
+const int MAX_TRANSFORM_DEPTH = 16;
+
+// Unit meshes behind the batch's own shapes, first in every mesh table
+enum UnitMesh
+{
+    MESH_TRIANGLE, // (0, 0), (1, 0), (0, 1): the transform's columns are two edges
+    MESH_RECT,     // [0, 1] x [0, 1]
+    MESH_SEGMENT,  // [0, 1] x [-0.5, 0.5]: a one-unit-wide line from (0, 0) to (1, 0)
+    MESH_POINT,    // [-0.5, 0.5] x [-0.5, 0.5]
+    UNIT_MESHES
+};
+
+// Every mesh's triangles back to back, so one vertex pointer covers them all
+struct MeshTable
+{
+    std::vector<float> points;     // x, y pairs
+    std::vector<int> first, count; // per mesh, in vertices
+};
+
+static MeshTable &meshTable();
+
+static std::vector<DrawCommand> commands;
+static std::vector<BatchVertex> vertices;
+static DrawTransform transforms[MAX_TRANSFORM_DEPTH] = {{1, 0, 0, 1, 0, 0}};
+static int depth = 0;
+static float color[3] = {1, 1, 1};
+static unsigned char r = 255, g = 255, b = 255;
+static int layer = 0;
+static RenderBackend backend = BACKEND_BUFFER;
+static unsigned char *softwarePixels = nullptr;
+static int softwareWidth = 0, softwareHeight = 0;
+static bool useBuffer = false;
+static GLuint buffer = 0;
+static int lastVertexCount = 0;
+
+// A mesh's vertices, position and color interleaved as in the batch
+struct InstancedMesh
+{
+    GLuint buffer;
+    GLsizei vertexCount;
+};
+
+// Attribute locations, bound before linking
+const GLuint POSITION_ATTRIBUTE = 0;
+const GLuint COLOR_ATTRIBUTE = 1;
+const GLuint INSTANCE_ATTRIBUTE = 2;
+
+static const char *const INSTANCE_VERTEX_SHADER = R"(#version 120
+attribute vec2 position;
+attribute vec4 color;
+attribute vec3 instance; // x, y, degrees
+varying vec4 vertexColor;
+
+void main()
+{
+    float radians = instance.z * 0.0174532925;
+    float cosine = cos(radians);
+    float sine = sin(radians);
+    vec2 placed = vec2(position.x * cosine - position.y * sine, position.x * sine + position.y * cosine) + instance.xy;
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(placed, 0.0, 1.0);
+    vertexColor = color;
+}
+)";
+
+static const char *const INSTANCE_FRAGMENT_SHADER = R"(#version 120
+varying vec4 vertexColor;
+
+void main()
+{
+    gl_FragColor = vertexColor;
+}
+)";
+
+static bool useInstancing = false;
+static GLuint instanceProgram = 0;
+static GLuint instanceBuffer = 0;
+static std::vector<InstancedMesh> instancedMeshes;
+
+// Returns 0 if the source does not compile
+static GLuint compileShader(GLenum type, const char *source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint compiled = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (!compiled)
+    {
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Returns 0 if either shader or the link fails
+static GLuint linkInstanceProgram()
+{
+    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, INSTANCE_VERTEX_SHADER);
+    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, INSTANCE_FRAGMENT_SHADER);
+    GLuint program = 0;
+    if (vertexShader && fragmentShader)
+    {
+        program = glCreateProgram();
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, fragmentShader);
+        glBindAttribLocation(program, POSITION_ATTRIBUTE, "position");
+        glBindAttribLocation(program, COLOR_ATTRIBUTE, "color");
+        glBindAttribLocation(program, INSTANCE_ATTRIBUTE, "instance");
+        glLinkProgram(program);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    // The program keeps what it needs; deleting 0 is ignored
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+void initRenderer()
+{
+    useBuffer = glewInit() == GLEW_OK && GLEW_VERSION_1_5;
+    if (useBuffer)
+        glGenBuffers(1, &buffer);
+    vertices.reserve(1 << 16);
+    commands.reserve(1 << 12);
+
+    useInstancing = useBuffer && GLEW_VERSION_2_0 && GLEW_ARB_instanced_arrays && GLEW_ARB_draw_instanced;
+    if (useInstancing)
+    {
+        instanceProgram = linkInstanceProgram();
+        useInstancing = instanceProgram != 0;
+    }
+    if (useInstancing)
+        glGenBuffers(1, &instanceBuffer);
+}
+
+static int addPoints(MeshTable &table, const float *points, int count)
+{
+    table.first.push_back((int)table.points.size() / 2);
+    table.count.push_back(count);
+    table.points.insert(table.points.end(), points, points + 2 * count);
+    return (int)table.first.size() - 1;
+}
+
+// Built on first use, so meshes can be added from static initializers in any file
+static MeshTable &meshTable()
+{
+    static MeshTable table;
+    if (table.first.empty())
+    {
+        const float triangle[] = {0, 0, 1, 0, 0, 1};
+        const float rect[] = {0, 0, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1};
+        const float segment[] = {0, 0.5f, 1, 0.5f, 1, -0.5f, 0, 0.5f, 1, -0.5f, 0, -0.5f};
+        const float point[] = {-0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f};
+        addPoints(table, triangle, 3);
+        addPoints(table, rect, 6);
+        addPoints(table, segment, 6);
+        addPoints(table, point, 6);
+    }
+    return table;
+}
+
+void batchColor(float red, float green, float blue)
+{
+    color[0] = red;
+    color[1] = green;
+    color[2] = blue;
+    r = (unsigned char)(red * 255 + 0.5f);
+    g = (unsigned char)(green * 255 + 0.5f);
+    b = (unsigned char)(blue * 255 + 0.5f);
+}
+
+void currentBatchColor(float out[3])
+{
+    out[0] = color[0];
+    out[1] = color[1];
+    out[2] = color[2];
+}
+
+void batchLayer(int value)
+{
+    layer = value;
+}
+
+void batchPush()
+{
+    if (depth + 1 < MAX_TRANSFORM_DEPTH)
+    {
+        transforms[depth + 1] = transforms[depth];
+        depth++;
+    }
+}
+
+void batchPop()
+{
+    if (depth > 0)
+        depth--;
+}
+
+void batchTranslate(float x, float y)
+{
+    DrawTransform &t = transforms[depth];
+    t.tx += t.a * x + t.b * y;
+    t.ty += t.c * x + t.d * y;
+}
+
+void batchRotate(float degrees)
+{
+    float radians = degrees * 3.14159265f / 180;
+    float cosine = cosf(radians);
+    float sine = sinf(radians);
+    DrawTransform &t = transforms[depth];
+    DrawTransform rotated = {t.a * cosine + t.b * sine, t.b * cosine - t.a * sine, t.c * cosine + t.d * sine,
+                             t.d * cosine - t.c * sine, t.tx, t.ty};
+    t = rotated;
+}
+
+void batchScale(float scale)
+{
+    DrawTransform &t = transforms[depth];
+    t.a *= scale;
+    t.b *= scale;
+    t.c *= scale;
+    t.d *= scale;
+}
+
+static void record(int mesh, const DrawTransform &transform)
+{
+    DrawCommand command = {layer, mesh, r, g, b, 255, transform};
+    commands.push_back(command);
+}
+
+// `local` placed within the current transform
+static DrawTransform placed(const DrawTransform &local)
+{
+    const DrawTransform &t = transforms[depth];
+    return {t.a * local.a + t.b * local.c,          t.a * local.b + t.b * local.d,
+            t.c * local.a + t.d * local.c,          t.c * local.b + t.d * local.d,
+            t.a * local.tx + t.b * local.ty + t.tx, t.c * local.tx + t.d * local.ty + t.ty};
+}
+
+void batchTriangle(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    record(MESH_TRIANGLE, placed({x2 - x1, x3 - x1, y2 - y1, y3 - y1, x1, y1}));
+}
+
+void batchRect(float x1, float y1, float x2, float y2)
+{
+    record(MESH_RECT, placed({x2 - x1, 0, 0, y2 - y1, x1, y1}));
+}
+
+void batchPolygon(const float *points, int count)
+{
+    for (int i = 1; i + 1 < count; i++)
+        batchTriangle(points[0], points[1], points[2 * i], points[2 * i + 1], points[2 * i + 2], points[2 * i + 3]);
+}
+
+void batchLineStrip(const float *points, int count)
+{
+    const DrawTransform &t = transforms[depth];
+    for (int i = 0; i + 1 < count; i++)
+    {
+        // Each segment is one pixel wide, so it is placed in window coordinates
+        float x1 = t.a * points[2 * i] + t.b * points[2 * i + 1] + t.tx;
+        float y1 = t.c * points[2 * i] + t.d * points[2 * i + 1] + t.ty;
+        float x2 = t.a * points[2 * i + 2] + t.b * points[2 * i + 3] + t.tx;
+        float y2 = t.c * points[2 * i + 2] + t.d * points[2 * i + 3] + t.ty;
+        float length = sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+        if (length == 0)
+            continue;
+        record(MESH_SEGMENT, {x2 - x1, (y1 - y2) / length, y2 - y1, (x2 - x1) / length, x1, y1});
+    }
+}
+
+void batchPoint(float x, float y, float size)
+{
+    const DrawTransform &t = transforms[depth];
+    float cx = t.a * x + t.b * y + t.tx;
+    float cy = t.c * x + t.d * y + t.ty;
+    record(MESH_POINT, {size, 0, 0, size, cx, cy});
+}
+
+void meshTriangle(Mesh &mesh, float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    const float corners[] = {x1, y1, x2, y2, x3, y3};
+    mesh.triangles.insert(mesh.triangles.end(), corners, corners + 6);
+}
+
+void meshPolygon(Mesh &mesh, const float *points, int count)
+{
+    for (int i = 1; i + 1 < count; i++)
+        meshTriangle(mesh, points[0], points[1], points[2 * i], points[2 * i + 1], points[2 * i + 2], points[2 * i + 3]);
+}
+
+void meshLineStrip(Mesh &mesh, const float *points, int count)
+{
+    for (int i = 0; i + 1 < count; i++)
+    {
+        float x1 = points[2 * i], y1 = points[2 * i + 1];
+        float x2 = points[2 * i + 2], y2 = points[2 * i + 3];
+        float length = sqrtf((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+        if (length == 0)
+            continue;
+        float nx = (y1 - y2) / length * 0.5f;
+        float ny = (x2 - x1) / length * 0.5f;
+        meshTriangle(mesh, x1 + nx, y1 + ny, x2 + nx, y2 + ny, x2 - nx, y2 - ny);
+        meshTriangle(mesh, x1 + nx, y1 + ny, x2 - nx, y2 - ny, x1 - nx, y1 - ny);
+    }
+}
+
+int addMesh(const Mesh &mesh)
+{
+    return addPoints(meshTable(), mesh.triangles.data(), (int)mesh.triangles.size() / 2);
+}
+
+void batchMesh(int mesh)
+{
+    record(mesh, transforms[depth]);
+}
+
+void setRenderBackend(RenderBackend value)
+{
+    backend = value;
+}
+
+RenderBackend renderBackend()
+{
+    return backend;
+}
+
+const char *backendName(RenderBackend value)
+{
+    static const char *const NAMES[RENDER_BACKENDS] = {"buffer", "legacy", "software", "null"};
+    return value >= 0 && value < RENDER_BACKENDS ? NAMES[value] : "";
+}
+
+void setSoftwareTarget(unsigned char *pixels, int width, int height)
+{
+    softwarePixels = pixels;
+    softwareWidth = width;
+    softwareHeight = height;
+}
+
+void takeCommands(std::vector<DrawCommand> &out)
+{
+    out.assign(commands.begin(), commands.end());
+    commands.clear();
+}
+
+void sortCommands(std::vector<DrawCommand> &list)
+{
+    std::stable_sort(list.begin(), list.end(), [](const DrawCommand &x, const DrawCommand &y) {
+        if (x.layer != y.layer)
+            return x.layer < y.layer;
+        if (x.mesh != y.mesh)
+            return x.mesh < y.mesh;
+        unsigned int xColor = x.r << 24 | x.g << 16 | x.b << 8 | x.a;
+        unsigned int yColor = y.r << 24 | y.g << 16 | y.b << 8 | y.a;
+        return xColor < yColor;
+    });
+}
+
+// Every command's triangles in window coordinates, appended to `out`
+static void transformCommands(const std::vector<DrawCommand> &list, std::vector<BatchVertex> &out)
+{
+    const MeshTable &table = meshTable();
+    for (const DrawCommand &command : list)
+    {
+        const DrawTransform &t = command.transform;
+        const float *point = &table.points[2 * table.first[command.mesh]];
+        for (int i = 0; i < table.count[command.mesh]; i++, point += 2)
+        {
+            BatchVertex vertex = {t.a * point[0] + t.b * point[1] + t.tx, t.c * point[0] + t.d * point[1] + t.ty,
+                                  command.r, command.g, command.b, command.a};
+            out.push_back(vertex);
+        }
+    }
+}
+
+static void drawBuffer(const std::vector<DrawCommand> &list)
+{
+    vertices.clear();
+    transformCommands(list, vertices);
+    if (vertices.empty())
+        return;
+
+    const char *base = (const char *)vertices.data();
+    if (useBuffer)
+    {
+        // Respecifying the whole store every frame lets the driver hand out fresh memory
+        // instead of waiting for the previous frame's draw to finish reading it
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(BatchVertex), base, GL_STREAM_DRAW);
+        base = nullptr;
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(BatchVertex), base);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), base + offsetof(BatchVertex, r));
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)vertices.size());
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    if (useBuffer)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Sorting pays off here: the color is only set when it changes
+static void drawLegacy(const std::vector<DrawCommand> &list)
+{
+    const MeshTable &table = meshTable();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, table.points.data());
+    glMatrixMode(GL_MODELVIEW);
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        const DrawCommand &command = list[i];
+        if (i == 0 || memcmp(&command.r, &list[i - 1].r, 4) != 0)
+            glColor4ub(command.r, command.g, command.b, command.a);
+
+        // Column-major, as GL wants it
+        const DrawTransform &t = command.transform;
+        const GLfloat matrix[16] = {t.a, t.c, 0, 0, t.b, t.d, 0, 0, 0, 0, 1, 0, t.tx, t.ty, 0, 1};
+        glPushMatrix();
+        glMultMatrixf(matrix);
+        glDrawArrays(GL_TRIANGLES, table.first[command.mesh], table.count[command.mesh]);
+        glPopMatrix();
+    }
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Fills the pixels whose centers lie inside the triangle. A center right on an edge goes to the triangle
+// to the right of or above that edge, so neighbors sharing it neither both fill it nor both miss it.
+static void fillTriangle(const BatchVertex &p, const BatchVertex &q, const BatchVertex &s)
+{
+    float area = (q.x - p.x) * (s.y - p.y) - (q.y - p.y) * (s.x - p.x);
+    if (area == 0)
+        return;
+    const BatchVertex *v[3] = {&p, area > 0 ? &q : &s, area > 0 ? &s : &q}; // counterclockwise
+
+    int x1 = std::max(0, (int)floorf(std::min({p.x, q.x, s.x})));
+    int x2 = std::min(softwareWidth - 1, (int)ceilf(std::max({p.x, q.x, s.x})));
+    int y1 = std::max(0, (int)floorf(std::min({p.y, q.y, s.y})));
+    int y2 = std::min(softwareHeight - 1, (int)ceilf(std::max({p.y, q.y, s.y})));
+    for (int y = y1; y <= y2; y++)
+    {
+        unsigned char *row = softwarePixels + (size_t)(softwareHeight - 1 - y) * softwareWidth * 3;
+        float cy = y + 0.5f;
+        for (int x = x1; x <= x2; x++)
+        {
+            float cx = x + 0.5f;
+            bool inside = true;
+            for (int e = 0; e < 3 && inside; e++)
+            {
+                const BatchVertex &from = *v[e], &to = *v[(e + 1) % 3];
+                float dx = to.x - from.x, dy = to.y - from.y;
+                float edge = dx * (cy - from.y) - dy * (cx - from.x);
+                bool owned = dy < 0 || (dy == 0 && dx > 0);
+                inside = edge > 0 || (edge == 0 && owned);
+            }
+            if (inside)
+            {
+                row[3 * x] = p.r;
+                row[3 * x + 1] = p.g;
+                row[3 * x + 2] = p.b;
+            }
+        }
+    }
+}
+
+static void drawSoftware(const std::vector<DrawCommand> &list)
+{
+    if (!softwarePixels)
+        return;
+    vertices.clear();
+    transformCommands(list, vertices);
+    for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+        fillTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+}
+
+void executeCommands(RenderBackend with, const std::vector<DrawCommand> &list)
+{
+    switch (with)
+    {
+    case BACKEND_BUFFER:
+        drawBuffer(list);
+        break;
+    case BACKEND_LEGACY:
+        drawLegacy(list);
+        break;
+    case BACKEND_SOFTWARE:
+        drawSoftware(list);
+        break;
+    default:
+        break;
+    }
+}
+
+void flushBatch()
+{
+    if (commands.empty())
+        return;
+    const MeshTable &table = meshTable();
+    lastVertexCount = 0;
+    for (const DrawCommand &command : commands)
+        lastVertexCount += table.count[command.mesh];
+
+    sortCommands(commands);
+    executeCommands(backend, commands);
+    commands.clear();
+}
+
+int batchVertexCount()
+{
+    return lastVertexCount;
+}
+
+void takeBatch(std::vector<BatchVertex> &out)
+{
+    sortCommands(commands);
+    out.clear();
+    transformCommands(commands, out);
+    commands.clear();
+}
+
+bool instancingSupported()
+{
+    return useInstancing;
+}
+
+int createInstancedMesh(const std::vector<BatchVertex> &meshVertices)
+{
+    InstancedMesh mesh = {0, (GLsizei)meshVertices.size()};
+    glGenBuffers(1, &mesh.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+    glBufferData(GL_ARRAY_BUFFER, meshVertices.size() * sizeof(BatchVertex), meshVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    instancedMeshes.push_back(mesh);
+    return (int)instancedMeshes.size() - 1;
+}
+
+void drawInstances(int id, const MeshInstance *instances, int count)
+{
+    if (count == 0)
+        return;
+    const InstancedMesh &mesh = instancedMeshes[id];
+    glUseProgram(instanceProgram);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.buffer);
+    glEnableVertexAttribArray(POSITION_ATTRIBUTE);
+    glEnableVertexAttribArray(COLOR_ATTRIBUTE);
+    glVertexAttribPointer(POSITION_ATTRIBUTE, 2, GL_FLOAT, GL_FALSE, sizeof(BatchVertex), nullptr);
+    glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BatchVertex),
+                          (const void *)offsetof(BatchVertex, r));
+
+    // The instances change every frame, so their buffer is respecified like the batch's
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(MeshInstance), instances, GL_STREAM_DRAW);
+    glEnableVertexAttribArray(INSTANCE_ATTRIBUTE);
+    glVertexAttribPointer(INSTANCE_ATTRIBUTE, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), nullptr);
+    glVertexAttribDivisorARB(INSTANCE_ATTRIBUTE, 1);
+
+    glDrawArraysInstancedARB(GL_TRIANGLES, 0, mesh.vertexCount, count);
+
+    glVertexAttribDivisorARB(INSTANCE_ATTRIBUTE, 0);
+    glDisableVertexAttribArray(INSTANCE_ATTRIBUTE);
+    glDisableVertexAttribArray(COLOR_ATTRIBUTE);
+    glDisableVertexAttribArray(POSITION_ATTRIBUTE);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
+
+bool createRenderLayer(RenderLayer &layer, int width, int height)
+{
+    if (!GLEW_EXT_framebuffer_object)
+        return false;
+
+    glGenTextures(1, &layer.texture);
+    glBindTexture(GL_TEXTURE_2D, layer.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffersEXT(1, &layer.framebuffer);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, layer.framebuffer);
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, layer.texture, 0);
+    bool complete = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) == GL_FRAMEBUFFER_COMPLETE_EXT;
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+    if (!complete)
+    {
+        glDeleteFramebuffersEXT(1, &layer.framebuffer);
+        glDeleteTextures(1, &layer.texture);
+        layer = RenderLayer();
+        return false;
+    }
+    layer.width = width;
+    layer.height = height;
+    return true;
+}
+
+void beginRenderLayer(const RenderLayer &layer)
+{
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, layer.framebuffer);
+    glPushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT);
+    glViewport(0, 0, layer.width, layer.height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void endRenderLayer()
+{
+    glPopAttrib();
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+}
+
+void drawRenderLayer(const RenderLayer &layer, const float *bands, int count)
+{
+    // x, y, u, v of two triangles per band
+    float quads[MAX_LAYER_BANDS * 6 * 4];
+    int n = 0;
+    for (int i = 0; i < count && i < MAX_LAYER_BANDS; i++)
+    {
+        float y1 = bands[2 * i], y2 = bands[2 * i + 1];
+        float v1 = y1 / layer.height, v2 = y2 / layer.height;
+        float w = (float)layer.width;
+        const float corners[6][4] = {{0, y1, 0, v1}, {w, y1, 1, v1}, {w, y2, 1, v2},
+                                     {0, y1, 0, v1}, {w, y2, 1, v2}, {0, y2, 0, v2}};
+        for (auto &corner : corners)
+        {
+            for (float value : corner)
+                quads[n++] = value;
+        }
+    }
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, layer.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 4 * sizeof(float), quads);
+    glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(float), quads + 2);
+    glDrawArrays(GL_TRIANGLES, 0, n / 4);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+
+// Records a frame's shapes as draw commands, each a mesh with a transform, color and layer, and draws them
+// at flushBatch() with whichever backend is selected. Coordinates are window coordinates, as with gluOrtho2D.
+struct BatchVertex
+{
+    float x, y;
+    unsigned char r, g, b, a;
+};
+
+// Needs the GL context: loads the buffer entry points through GLEW.
+// Without vertex buffer support, the buffer backend falls back to plain vertex arrays.
+void initRenderer();
+
+void batchColor(float r, float g, float b);
+void currentBatchColor(float color[3]); // for drawing that does not go through the batch
+
+// Draw order within a flush: commands go out layer by layer, and within a layer they are grouped by
+// mesh and color, so a shape that has to cover another from the same flush needs a later layer
+void batchLayer(int layer);
+
+// Transform stack, like glPushMatrix/glTranslatef/glRotatef but applied on the CPU
+void batchPush();
+void batchPop();
+void batchTranslate(float x, float y);
+void batchRotate(float degrees);
+void batchScale(float scale);
+
+void batchTriangle(float x1, float y1, float x2, float y2, float x3, float y3);
+void batchRect(float x1, float y1, float x2, float y2);
+void batchPolygon(const float *points, int count); // x, y pairs; drawn as a fan like GL_POLYGON
+void batchLineStrip(const float *points, int count); // one pixel wide
+void batchPoint(float x, float y, float size);      // a size x size square that ignores rotation
+
+// A shape tessellated once into triangles in its own coordinates, to be added as often as needed
+struct Mesh
+{
+    std::vector<float> triangles; // x, y of each vertex, three vertices per triangle
+};
+
+void meshTriangle(Mesh &, float x1, float y1, float x2, float y2, float x3, float y3);
+void meshPolygon(Mesh &, const float *points, int count);   // a fan like GL_POLYGON
+void meshLineStrip(Mesh &, const float *points, int count); // one unit wide
+
+// Copies the mesh into the renderer's table and returns its id; works before initRenderer()
+int addMesh(const Mesh &);
+
+// Adds the mesh with the current transform, color and layer
+void batchMesh(int mesh);
+
+// Draws everything added since the last flush, then empties the batch
+void flushBatch();
+
+// Vertices drawn by the last flush that had any
+int batchVertexCount();
+
+// Row-major 2D affine transform: x' = a x + b y + tx, y' = c x + d y + ty
+struct DrawTransform
+{
+    float a, b, c, d, tx, ty;
+};
+
+// One recorded shape. The batch's own shapes use unit meshes of the renderer's, stretched by the transform.
+struct DrawCommand
+{
+    int layer;
+    int mesh;
+    unsigned char r, g, b, a;
+    DrawTransform transform; // mesh coordinates to window coordinates
+};
+
+// What executes a flush's commands. All of them draw the same pixels from the same commands:
+// BACKEND_BUFFER transforms every vertex on the CPU into one stream and draws it with one call;
+// BACKEND_LEGACY leaves transforms to the GL matrix stack, one draw per command and a glColor per color change;
+// BACKEND_SOFTWARE fills the triangles into the image given to setSoftwareTarget(), without GL;
+// BACKEND_NULL draws nothing, which leaves the cost of recording and sorting.
+enum RenderBackend
+{
+    BACKEND_BUFFER,
+    BACKEND_LEGACY,
+    BACKEND_SOFTWARE,
+    BACKEND_NULL,
+    RENDER_BACKENDS
+};
+
+void setRenderBackend(RenderBackend); // BACKEND_BUFFER until set
+RenderBackend renderBackend();
+const char *backendName(RenderBackend);
+
+// RGB, top row first; window pixel x, y lands at column x, row height - 1 - y
+void setSoftwareTarget(unsigned char *pixels, int width, int height);
+
+// Takes the commands added since the last flush, in the order they were added, without drawing them
+void takeCommands(std::vector<DrawCommand> &);
+
+// Stable sort by layer, then mesh, then color: the order backends expect
+void sortCommands(std::vector<DrawCommand> &);
+
+// Draws sorted commands with the given backend, whichever is selected
+void executeCommands(RenderBackend, const std::vector<DrawCommand> &);
+
+// An offscreen texture drawn into through a framebuffer object, for parts of the screen that rarely change.
+// Between beginRenderLayer() and endRenderLayer(), drawing goes to the layer instead of the window,
+// with the same coordinates; flush what is batched before either call. Needs EXT_framebuffer_object.
+struct RenderLayer
+{
+    unsigned int texture = 0, framebuffer = 0;
+    int width = 0, height = 0;
+};
+
+// Returns false if the GL cannot render to a texture; the layer is then left empty
+bool createRenderLayer(RenderLayer &, int width, int height);
+
+// Clears the layer to transparent
+void beginRenderLayer(const RenderLayer &);
+void endRenderLayer();
+
+// Copies up to MAX_LAYER_BANDS whole-width bands of the layer to the same place in the window, in one draw.
+// `bands` holds y1, y2 pairs; the layer's pixels replace the window's, alpha and all, so the bands should be opaque.
+const int MAX_LAYER_BANDS = 4;
+void drawRenderLayer(const RenderLayer &, const float *bands, int count);
+
+// Takes everything added since the last flush as sorted, transformed vertices without drawing it,
+// e.g. to turn shapes into an instanced mesh
+void takeBatch(std::vector<BatchVertex> &);
+
+// Instanced drawing: a mesh with its own colors is uploaded once, then drawn at any number of places in one call.
+// A small vertex shader rotates and moves each copy; the GL matrices still apply on top.
+// Needs shaders and instanced arrays; without them, draw through the batch instead.
+struct MeshInstance
+{
+    float x, y;
+    float degrees; // counterclockwise, like batchRotate
+};
+
+bool instancingSupported();
+
+// Returns the id to pass to drawInstances()
+int createInstancedMesh(const std::vector<BatchVertex> &);
+
+// Flush the batch first if the instances should go over what it holds
+void drawInstances(int mesh, const MeshInstance *instances, int count);
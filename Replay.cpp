@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cstring>
+#include "Replay.h"
+
+const char REPLAY_MAGIC[4] = {'2', 'D', 'R', 'P'};
+const unsigned char REPLAY_VERSION = 1;
+
+static void writeBytes(std::vector<unsigned char> &out, unsigned long long value, int bytes)
+{
+    for (int b = 0; b < bytes; b++)
+        out.push_back((unsigned char)(value >> (8 * b)));
+}
+
+static bool readBytes(const std::vector<unsigned char> &in, size_t &pos, unsigned long long &value, int bytes)
+{
+    if (in.size() - pos < (size_t)bytes)
+        return false;
+    value = 0;
+    for (int b = 0; b < bytes; b++)
+        value |= (unsigned long long)in[pos++] << (8 * b);
+    return true;
+}
+
+bool saveReplay(const char *path, const Replay &replay)
+{
+    // The tick count has four bytes
+    if (replay.inputs.size() > 0xffffffffull)
+        return false;
+
+    std::vector<unsigned char> out(REPLAY_MAGIC, REPLAY_MAGIC + 4);
+    out.push_back(REPLAY_VERSION);
+    writeBytes(out, replay.seed, 8);
+    writeBytes(out, replay.inputs.size(), 4);
+    writeBytes(out, (unsigned int)replay.finalScore, 4);
+    writeBytes(out, (unsigned int)replay.finalLives, 4);
+
+    // Most ticks have no input, so runs of equal keys keep files small
+    for (size_t t = 0; t < replay.inputs.size();)
+    {
+        size_t run = 1;
+        while (t + run < replay.inputs.size() && replay.inputs[t + run] == replay.inputs[t])
+            run++;
+        out.push_back(replay.inputs[t]);
+        for (size_t left = run; ; left >>= 7)
+        {
+            out.push_back((unsigned char)((left & 0x7f) | (left > 0x7f ? 0x80 : 0)));
+            if (left <= 0x7f)
+                break;
+        }
+        t += run;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+    bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+    return fclose(file) == 0 && written;
+}
+
+bool loadReplay(const char *path, Replay &replay)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+    std::vector<unsigned char> in;
+    unsigned char chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        in.insert(in.end(), chunk, chunk + got);
+    fclose(file);
+
+    if (in.size() < 5 || memcmp(in.data(), REPLAY_MAGIC, 4) != 0 || in[4] != REPLAY_VERSION)
+        return false;
+
+    size_t pos = 5;
+    unsigned long long seed, ticks, score, lives;
+    if (!readBytes(in, pos, seed, 8) || !readBytes(in, pos, ticks, 4) || !readBytes(in, pos, score, 4) ||
+        !readBytes(in, pos, lives, 4))
+        return false;
+    replay.seed = seed;
+    replay.finalScore = (int)(unsigned int)score;
+    replay.finalLives = (int)(unsigned int)lives;
+
+    // No reserve from the header: a corrupt count must not allocate before any run backs it up
+    replay.inputs.clear();
+    while (replay.inputs.size() < ticks)
+    {
+        if (pos >= in.size())
+            return false;
+        unsigned char keys = in[pos++];
+        unsigned long long run = 0;
+        for (int shift = 0; ; shift += 7)
+        {
+            if (pos >= in.size() || shift > 28)
+                return false;
+            unsigned char byte = in[pos++];
+            run |= (unsigned long long)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        if (run == 0 || run > ticks - replay.inputs.size())
+            return false;
+        replay.inputs.insert(replay.inputs.end(), run, keys);
+    }
+    return pos == in.size();
+}
+
+void runReplay(const Replay &replay, GameState &state)
+{
+    initGame(state, replay.seed);
+    for (unsigned char keys : replay.inputs)
+        step(state, GameInput{keys});
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include "Simulation.h"
+
+// A recorded run: the seed, the keys of every tick, and how the game ended
+struct Replay
+{
+    unsigned long long seed;
+    std::vector<unsigned char> inputs; // GameInput::keys, one per tick
+    int finalScore;
+    int finalLives;
+};
+
+// File layout, little-endian: "2DRP", version byte, seed (8 bytes), tick count (4), final score (4),
+// final lives (4), then the inputs as runs of (keys byte, run length as a base-128 varint).
+// Both return false if the file cannot be opened or is not a replay; saving also fails past 2^32 - 1 ticks.
+bool saveReplay(const char *, const Replay &);
+bool loadReplay(const char *, Replay &);
+
+// Re-runs a replay from a fresh game as fast as possible, leaving the final state in `state`
+void runReplay(const Replay &, GameState &);
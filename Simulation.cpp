@@ -0,0 +1,409 @@
+#include <cmath>
+#include "Profiler.h"
+#include "Simulation.h"
+
+void seedRng(GameRng &rng, unsigned long long seed)
+{
+    // splitmix64 spreads nearby seeds into unrelated keys; Squares wants an odd key
+    unsigned long long z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    rng.key = (z ^ (z >> 31)) | 1;
+    rng.counter = 0;
+}
+
+unsigned int nextRandom(GameRng &rng)
+{
+    unsigned long long x = rng.counter++ * rng.key;
+    unsigned long long y = x;
+    unsigned long long z = y + rng.key;
+    x = x * x + y;
+    x = (x >> 32) | (x << 32);
+    x = x * x + z;
+    x = (x >> 32) | (x << 32);
+    x = x * x + y;
+    x = (x >> 32) | (x << 32);
+    return (unsigned int)((x * x + z) >> 32);
+}
+
+static void resetGame(GameState &state)
+{
+    // Initialize game variables
+    state.gameSpeed = INITIAL_GAME_SPEED;
+    state.gameTime = GAME_DURATION;
+    state.lives = INITIAL_LIVES;
+    state.score = 0;
+
+    state.gameState = 0;
+    state.paused = false;
+
+    state.playerY = PLAYER_BASE_Y;
+    state.jumpSpeed = JUMP_SPEED_INIT;
+
+    state.isJumping = false;
+    state.isDucking = false;
+    state.isInvincible = false;
+    state.isDoublePoints = false;
+
+    state.powerup1ActiveTime = POWERUP1_ACTIVE_TIME;
+    state.powerup2ActiveTime = POWERUP2_ACTIVE_TIME;
+
+    state.obstacleSpawnTimer = 0;
+    state.collectableSpawnTimer = 0;
+    state.powerupSpawnTimer = 0;
+    state.obstacleSpawnInterval = OBSTACLE_SPAWN_INTERVAL;
+    state.collectableSpawnInterval = COLLECTABLE_SPAWN_INTERVAL;
+    state.powerupSpawnInterval = POWERUP_SPAWN_INTERVAL;
+
+    state.collectableAngle = 0;
+    state.oscillatePowerupY = 0;
+    state.oscillatePowerupDY = 1;
+
+    for (auto &pool : state.entities)
+        pool.clear();
+}
+
+void initGame(GameState &state, unsigned long long seed)
+{
+    seedRng(state.rng, seed);
+    resetGame(state);
+}
+
+void rollbackGame(GameState &state)
+{
+    // Rollback game variables when player hits an obstacle
+    state.gameSpeed = INITIAL_GAME_SPEED;
+    state.gameState = 1;
+    state.paused = false;
+
+    state.playerY = PLAYER_BASE_Y;
+    state.jumpSpeed = JUMP_SPEED_INIT;
+
+    state.isJumping = false;
+    state.isDucking = false;
+    state.isInvincible = false;
+    state.isDoublePoints = false;
+
+    state.powerup1ActiveTime = POWERUP1_ACTIVE_TIME;
+    state.powerup2ActiveTime = POWERUP2_ACTIVE_TIME;
+
+    state.obstacleSpawnTimer = 0;
+    state.collectableSpawnTimer = 0;
+    state.powerupSpawnTimer = 0;
+    state.obstacleSpawnInterval = OBSTACLE_SPAWN_INTERVAL;
+    state.collectableSpawnInterval = COLLECTABLE_SPAWN_INTERVAL;
+    state.powerupSpawnInterval = POWERUP_SPAWN_INTERVAL;
+
+    state.collectableAngle = 0;
+
+    state.oscillatePowerupY = 0;
+    state.oscillatePowerupDY = 1;
+
+    for (auto &pool : state.entities)
+        pool.clear();
+}
+
+void pressKey(GameState &state, unsigned char key)
+{
+    if (key == 'r')
+    {
+        resetGame(state);
+        state.gameState = 1;
+    }
+    else if (key == ' ' && state.gameState == 0)
+    {
+        state.gameState = 1;
+    }
+    else if (key == 'j' && state.playerY <= PLAYER_BASE_Y && !state.isJumping && !state.isDucking)
+    {
+        state.isDucking = true;
+    }
+    else if (key == 'k' && state.playerY <= PLAYER_BASE_Y && !state.isJumping && !state.isDucking)
+    {
+        state.isJumping = true;
+    }
+    else if (key == 'p')
+    {
+        state.paused = !state.paused;
+    }
+}
+
+void releaseKey(GameState &state, unsigned char key)
+{
+    if (key == 'j')
+    {
+        state.isDucking = false;
+    }
+}
+
+static void applyInput(GameState &state, GameInput input)
+{
+    if (input.keys & INPUT_RESTART)
+        pressKey(state, 'r');
+    if (input.keys & INPUT_START)
+        pressKey(state, ' ');
+    if (input.keys & INPUT_DUCK)
+        pressKey(state, 'j');
+    if (input.keys & INPUT_JUMP)
+        pressKey(state, 'k');
+    if (input.keys & INPUT_PAUSE)
+        pressKey(state, 'p');
+    if (input.keys & INPUT_DUCK_UP)
+        releaseKey(state, 'j');
+}
+
+// Applies what touching an entity does; returns false if the game rolled back
+static bool applyHit(GameState &state, EntityEffect effect)
+{
+    switch (effect)
+    {
+    case EFFECT_DAMAGE:
+        state.lives--;
+        if (state.lives <= 0)
+        {
+            state.gameState = 2;
+            return true;
+        }
+        rollbackGame(state);
+        return false;
+    case EFFECT_SCORE:
+        state.score += state.isDoublePoints ? 20 : 10;
+        return true;
+    case EFFECT_INVINCIBILITY:
+        state.isInvincible = true;
+        state.powerup1ActiveTime = POWERUP1_ACTIVE_TIME;
+        return true;
+    case EFFECT_DOUBLE_POINTS:
+        state.isDoublePoints = true;
+        state.powerup2ActiveTime = POWERUP2_ACTIVE_TIME;
+        return true;
+    }
+    return true;
+}
+
+void step(GameState &state, GameInput input)
+{
+    applyInput(state, input);
+
+    state.backgroundX += 1;
+    if (state.backgroundX >= WINDOW_WIDTH)
+    {
+        state.backgroundX = -WINDOW_WIDTH;
+    }
+
+    if (state.gameState != 1 || state.paused)
+        return;
+
+    PhaseTimer timer;
+
+    // Update timings
+    state.gameTime -= 1.0 / FPS;
+    state.obstacleSpawnTimer -= 1.0 / FPS;
+    state.collectableSpawnTimer -= 1.0 / FPS;
+    state.powerupSpawnTimer -= 1.0 / FPS;
+
+    state.collectableAngle += 5.0f;
+    state.oscillatePowerupY += state.oscillatePowerupDY * 0.5;
+    if (state.oscillatePowerupY > 2 || state.oscillatePowerupY < -2)
+        state.oscillatePowerupDY *= -1;
+
+    // Update powerups
+    if (state.isInvincible)
+        state.powerup1ActiveTime -= 1.0 / FPS;
+    if (state.isDoublePoints)
+        state.powerup2ActiveTime -= 1.0 / FPS;
+
+    if (state.powerup1ActiveTime <= 0)
+    {
+        state.isInvincible = false;
+        state.powerup1ActiveTime = POWERUP1_ACTIVE_TIME;
+    }
+    if (state.powerup2ActiveTime <= 0)
+    {
+        state.isDoublePoints = false;
+        state.powerup2ActiveTime = POWERUP2_ACTIVE_TIME;
+    }
+
+    if (state.gameTime <= 0)
+    {
+        state.gameState = 2;
+    }
+
+    // Update game speed
+    state.gameSpeed += GAME_SPEED_INCREASE;
+    state.jumpSpeed += GAME_SPEED_INCREASE;
+    state.obstacleSpawnInterval = OBSTACLE_SPAWN_INTERVAL / state.gameSpeed;
+    state.collectableSpawnInterval = COLLECTABLE_SPAWN_INTERVAL / state.gameSpeed;
+    state.powerupSpawnInterval = POWERUP_SPAWN_INTERVAL / state.gameSpeed;
+    timer.lap(PHASE_TIMERS);
+
+    // Update player position
+    if (state.isJumping)
+    {
+        state.playerY += state.jumpSpeed;
+        if (state.playerY >= PLAYER_BASE_Y + JUMP_HEIGHT)
+        {
+            state.isJumping = false;
+        }
+    }
+    else if (state.playerY > PLAYER_BASE_Y && !state.isDucking)
+    {
+        state.playerY -= state.jumpSpeed;
+    }
+
+    if (state.isDucking)
+    {
+        state.playerY = PLAYER_BASE_Y - DUCK_HEIGHT;
+    }
+    else if (!state.isJumping && state.playerY < PLAYER_BASE_Y)
+    {
+        state.playerY = PLAYER_BASE_Y;
+    }
+    timer.lap(PHASE_PLAYER);
+
+    // Update entities: every kind moves, collides and leaves the screen the same way
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        const EntityParams &params = ENTITY_PARAMS[kind];
+        float reach = PLAYER_SIZE / 2 + params.size / 2;
+        bool rolledBack = false;
+        for (auto &entity : state.entities[kind])
+        {
+            if (entity.active)
+            {
+                entity.x -= params.speed * state.gameSpeed;
+                if (params.oscillates)
+                    entity.y += state.oscillatePowerupY;
+
+                bool harmless = params.effect == EFFECT_DAMAGE && state.isInvincible;
+                if (!harmless && std::abs(entity.x - PLAYER_BASE_X) < reach && std::abs(entity.y - state.playerY) < reach)
+                {
+                    entity.active = false;
+                    if (!applyHit(state, params.effect))
+                    {
+                        // Rollback clears every pool, so there is nothing left to walk
+                        rolledBack = true;
+                        break;
+                    }
+                }
+
+                if (entity.x < -params.size)
+                {
+                    entity.active = false;
+                }
+            }
+        }
+        timer.lap(ProfilePhase(PHASE_OBSTACLES + kind));
+        if (rolledBack)
+            break;
+    }
+
+    // Spawn new objects
+    if (state.obstacleSpawnTimer <= 0 && state.entities[ENTITY_OBSTACLE].size() < MAX_OBSTACLES && nextRandom(state.rng) % 100 < OBSTACLE_SPAWN_PROB)
+    {
+        GameObject newObstacle;
+        newObstacle.x = WINDOW_WIDTH;
+        newObstacle.y = (PLAYER_BASE_Y + PLAYER_SIZE / 2 + PLAYER_HEAD_SIZE / 2) - (nextRandom(state.rng) % 2) * DUCK_HEIGHT;
+        newObstacle.active = true;
+        state.entities[ENTITY_OBSTACLE].push(newObstacle);
+        state.obstacleSpawnTimer = state.obstacleSpawnInterval;
+    }
+
+    if (
+        state.collectableSpawnTimer <= 0 &&
+        state.entities[ENTITY_COLLECTABLE].size() < MAX_COLLECTABLES && nextRandom(state.rng) % 100 < COLLECTABLE_SPAWN_PROB)
+    {
+        GameObject newCollectable;
+        newCollectable.x = WINDOW_WIDTH;
+        newCollectable.y = PLAYER_BASE_Y + (nextRandom(state.rng) % int(JUMP_HEIGHT - PLAYER_HEAD_SIZE / 2));
+        newCollectable.active = true;
+        state.entities[ENTITY_COLLECTABLE].push(newCollectable);
+        state.collectableSpawnTimer = state.collectableSpawnInterval;
+    }
+
+    bool isTypeOne = nextRandom(state.rng) % 2;
+    if (
+        isTypeOne &&
+        state.powerupSpawnTimer <= 0 &&
+        state.entities[ENTITY_POWERUP1].size() + state.entities[ENTITY_POWERUP2].size() < MAX_POWERUPS && nextRandom(state.rng) % 100 < POWERUP_SPAWN_PROB)
+    {
+        GameObject newPowerup;
+        newPowerup.x = WINDOW_WIDTH;
+        newPowerup.y = PLAYER_BASE_Y + (nextRandom(state.rng) % int(JUMP_HEIGHT - PLAYER_HEAD_SIZE / 2));
+        newPowerup.active = true;
+        state.entities[ENTITY_POWERUP1].push(newPowerup);
+        state.powerupSpawnTimer = state.powerupSpawnInterval;
+    }
+
+    if (
+        !isTypeOne &&
+        state.powerupSpawnTimer <= 0 &&
+        state.entities[ENTITY_POWERUP1].size() + state.entities[ENTITY_POWERUP2].size() < MAX_POWERUPS && nextRandom(state.rng) % 100 < POWERUP_SPAWN_PROB)
+    {
+        GameObject newPowerup;
+        newPowerup.x = WINDOW_WIDTH;
+        newPowerup.y = PLAYER_BASE_Y + (nextRandom(state.rng) % int(JUMP_HEIGHT - PLAYER_HEAD_SIZE / 2));
+        newPowerup.active = true;
+        state.entities[ENTITY_POWERUP2].push(newPowerup);
+        state.powerupSpawnTimer = state.powerupSpawnInterval;
+    }
+
+    timer.lap(PHASE_SPAWN);
+
+    // remove inactive objects
+    for (auto &pool : state.entities)
+        pool.removeInactive();
+    timer.lap(PHASE_COMPACT);
+}
+
+static float lerp(float from, float to, float alpha)
+{
+    return from + (to - from) * alpha;
+}
+
+// False across a restart, a start, a game over or a rollback: the player jumps back to the ground and
+// the pools are emptied, so nothing in `previous` is an earlier position of anything in `current`
+static bool isSameRun(const GameState &previous, const GameState &current)
+{
+    if (previous.gameState != 1 || current.gameState != 1)
+        return false;
+    // gameTime only counts down within a run; rollbackGame() leaves it alone but always costs a life
+    if (current.gameTime > previous.gameTime || current.lives != previous.lives)
+        return false;
+    // clear() resets head to 0, which nothing else ever moves back
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        if (current.entities[kind].head < previous.entities[kind].head)
+            return false;
+    }
+    return true;
+}
+
+void interpolateGame(GameState &out, const GameState &previous, const GameState &current, float alpha)
+{
+    out = current;
+    if (!isSameRun(previous, current))
+        return;
+
+    out.playerY = lerp(previous.playerY, current.playerY, alpha);
+    out.collectableAngle = lerp(previous.collectableAngle, current.collectableAngle, alpha);
+
+    // Slots keep their index from tick to tick, unless a squeeze moved them; an entity only counts as
+    // the same one if it is where one tick of movement from its old place would have put it
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        auto &pool = out.entities[kind];
+        const auto &before = previous.entities[kind];
+        float distance = float(ENTITY_PARAMS[kind].speed * current.gameSpeed);
+        for (unsigned int i = pool.head; i != pool.tail; i++)
+        {
+            GameObject &entity = pool.items[i % pool.CAPACITY];
+            const GameObject &old = before.items[i % before.CAPACITY];
+            if (i - before.head >= before.tail - before.head || !old.active || !entity.active ||
+                std::abs(old.x - distance - entity.x) > 1.0f)
+                continue;
+            entity.x = lerp(old.x, entity.x, alpha);
+            entity.y = lerp(old.y, entity.y, alpha);
+        }
+    }
+}
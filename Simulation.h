@@ -0,0 +1,255 @@
+#pragma once
+
+#include <type_traits>
+
+// Game constants
+// Running Config
+const int WINDOW_WIDTH = 800;
+const int WINDOW_HEIGHT = 600;
+const int FPS = 60;
+
+// Game Config
+const int INITIAL_LIVES = 5;
+const int INITIAL_GAME_SPEED = 2.1f;
+const int GAME_DURATION = 50;
+const float GAME_SPEED_INCREASE = 0.003f;
+
+// Player Config
+const float PLAYER_SIZE = 40.0f;
+const float PLAYER_HEAD_SIZE = 20.0f;
+const float PLAYER_BASE_Y = 100.0f;
+const float PLAYER_BASE_X = 50.0f;
+const float JUMP_HEIGHT = 120.0f;
+const float JUMP_SPEED_INIT = 10.0f;
+const float DUCK_HEIGHT = 25.0f;
+
+// Objects Config
+const float OBSTACLE_SIZE = 40.0f;
+const float COLLECTABLE_SIZE = 30.0f;
+const float POWERUP_SIZE = 30.0f;
+const int MAX_OBSTACLES = 10;
+const int MAX_COLLECTABLES = 5;
+const int MAX_POWERUPS = 2;
+const float OBSTACLE_SPAWN_PROB = 5.0f;
+const float COLLECTABLE_SPAWN_PROB = 3.0f;
+const float POWERUP_SPAWN_PROB = 5.0f;
+const float OBSTACLE_SPAWN_INTERVAL = 2.3f;
+const float COLLECTABLE_SPAWN_INTERVAL = 0.6f;
+const float POWERUP_SPAWN_INTERVAL = 20.0f;
+const float POWERUP1_ACTIVE_TIME = 5;
+const float POWERUP2_ACTIVE_TIME = 10;
+
+// Input Config
+// Key events received between two ticks, applied in this order by step()
+const unsigned char INPUT_RESTART = 1 << 0; // 'r'
+const unsigned char INPUT_START = 1 << 1;   // ' '
+const unsigned char INPUT_DUCK = 1 << 2;    // 'j' pressed
+const unsigned char INPUT_JUMP = 1 << 3;    // 'k' pressed
+const unsigned char INPUT_PAUSE = 1 << 4;   // 'p' pressed
+const unsigned char INPUT_DUCK_UP = 1 << 5; // 'j' released
+
+// Entity kinds, in the order step() updates them
+enum EntityKind
+{
+    ENTITY_OBSTACLE,
+    ENTITY_COLLECTABLE,
+    ENTITY_POWERUP1,
+    ENTITY_POWERUP2,
+    ENTITY_KINDS
+};
+
+// What touching the player does
+enum EntityEffect
+{
+    EFFECT_DAMAGE, // costs a life, ignored while invincible
+    EFFECT_SCORE,
+    EFFECT_INVINCIBILITY,
+    EFFECT_DOUBLE_POINTS
+};
+
+struct EntityParams
+{
+    double speed;    // moves left by speed * gameSpeed every tick
+    float size;
+    bool oscillates; // bobs up and down with oscillatePowerupY
+    EntityEffect effect;
+    int maxCount;    // the two powerup kinds also share MAX_POWERUPS
+};
+
+const EntityParams ENTITY_PARAMS[ENTITY_KINDS] = {
+    {2.7, OBSTACLE_SIZE, false, EFFECT_DAMAGE, MAX_OBSTACLES},
+    {4, COLLECTABLE_SIZE, false, EFFECT_SCORE, MAX_COLLECTABLES},
+    {3.5, POWERUP_SIZE, true, EFFECT_INVINCIBILITY, MAX_POWERUPS},
+    {3.5, POWERUP_SIZE, true, EFFECT_DOUBLE_POINTS, MAX_POWERUPS},
+};
+
+// Largest maxCount above, sizes every kind's pool
+const int MAX_KIND_COUNT = MAX_OBSTACLES;
+
+struct GameObject
+{
+    float x, y;
+    bool active;
+};
+
+// Smallest power of two that is at least n
+constexpr unsigned int poolCapacity(unsigned int n)
+{
+    return n <= 1 ? 1 : 2 * poolCapacity((n + 1) / 2);
+}
+
+template <typename Pool, typename Object>
+struct PoolIterator
+{
+    Pool *pool;
+    unsigned int index;
+
+    Object &operator*() const { return pool->items[index % Pool::CAPACITY]; }
+    PoolIterator &operator++()
+    {
+        index++;
+        return *this;
+    }
+    bool operator!=(const PoolIterator &other) const { return index != other.index; }
+};
+
+// Fixed-capacity FIFO of game objects that never allocates.
+// Objects spawn at the tail and leave from the head, so removing them is a head advance;
+// an object deactivated mid-list stays in place, inactive, until it reaches the head.
+// size() counts every object added since the last removeInactive(), like the vectors it replaced.
+// Callers keep size() below MAX_SIZE, so a squeeze always frees a slot.
+template <int MAX_SIZE>
+struct EntityPool
+{
+    static const unsigned int CAPACITY = poolCapacity(MAX_SIZE);
+
+    GameObject items[CAPACITY];
+    unsigned int head;
+    unsigned int tail;
+    int count;
+
+    int size() const { return count; }
+
+    void clear()
+    {
+        head = 0;
+        tail = 0;
+        count = 0;
+    }
+
+    void push(const GameObject &object)
+    {
+        if (tail - head == CAPACITY)
+            squeeze();
+        items[tail++ % CAPACITY] = object;
+        count++;
+    }
+
+    // Drops inactive objects from the head and recounts the active ones
+    void removeInactive()
+    {
+        while (head != tail && !items[head % CAPACITY].active)
+            head++;
+        count = 0;
+        for (unsigned int i = head; i != tail; i++)
+            count += items[i % CAPACITY].active;
+    }
+
+    // Only needed when mid-list gaps fill the whole ring: closes them up in place
+    void squeeze()
+    {
+        unsigned int kept = head;
+        for (unsigned int i = head; i != tail; i++)
+        {
+            if (items[i % CAPACITY].active)
+                items[kept++ % CAPACITY] = items[i % CAPACITY];
+        }
+        tail = kept;
+    }
+
+    PoolIterator<EntityPool, GameObject> begin() { return {this, head}; }
+    PoolIterator<EntityPool, GameObject> end() { return {this, tail}; }
+    PoolIterator<const EntityPool, const GameObject> begin() const { return {this, head}; }
+    PoolIterator<const EntityPool, const GameObject> end() const { return {this, tail}; }
+};
+
+// Counter-based random numbers (Widynski's Squares): draw n is a pure function of (key, n),
+// so a game's spawns depend only on its seed and inputs and games share no generator state
+struct GameRng
+{
+    unsigned long long key;
+    unsigned long long counter;
+};
+
+void seedRng(GameRng &, unsigned long long);
+unsigned int nextRandom(GameRng &);
+
+struct GameInput
+{
+    unsigned char keys;
+};
+
+// Everything update() reads and writes, so a game can be stepped without a window
+struct GameState
+{
+    int backgroundX = -WINDOW_WIDTH;
+    float gameSpeed;
+    float gameTime;
+    int gameState; // 0: Start, 1: Playing, 2: Game Over
+    int score;
+    int lives;
+    bool paused;
+    float playerY;
+    float jumpSpeed;
+    bool isJumping;
+    bool isDucking;
+    bool isInvincible;
+    bool isDoublePoints;
+    float powerup1ActiveTime;
+    float powerup2ActiveTime;
+    float obstacleSpawnTimer;
+    float collectableSpawnTimer;
+    float powerupSpawnTimer;
+    float obstacleSpawnInterval;
+    float collectableSpawnInterval;
+    float powerupSpawnInterval;
+    float collectableAngle;
+    float oscillatePowerupY;
+    float oscillatePowerupDY;
+    GameRng rng;
+
+    // One pool per EntityKind; each keeps its kind in spawn order
+    EntityPool<MAX_KIND_COUNT> entities[ENTITY_KINDS];
+};
+
+// A saved game. GameState holds no pointers or heap memory, so a plain copy is a complete snapshot:
+// pools, timers and the random stream included. Restoring and stepping with the same inputs
+// replays exactly what followed the save.
+struct GameSnapshot
+{
+    GameState state;
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay a flat copyable block");
+
+inline void saveSnapshot(const GameState &state, GameSnapshot &snapshot)
+{
+    snapshot.state = state;
+}
+
+inline void restoreSnapshot(GameState &state, const GameSnapshot &snapshot)
+{
+    state = snapshot.state;
+}
+
+// Starts a fresh game whose spawns are drawn from `seed`; restarting with 'r' keeps drawing from the same stream
+void initGame(GameState &, unsigned long long);
+void rollbackGame(GameState &);
+void pressKey(GameState &, unsigned char);
+void releaseKey(GameState &, unsigned char);
+void step(GameState &, GameInput);
+
+// For drawing between two ticks: `out` becomes `current`, with the player, the spinning and bobbing, and every
+// entity that `previous` already had moved back from `current` by 1 - alpha of a tick. alpha is in [0, 1].
+// Across a restart, start, game over or rollback nothing is blended and `out` is exactly `current`.
+void interpolateGame(GameState &out, const GameState &previous, const GameState &current, float alpha);
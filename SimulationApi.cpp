@@ -0,0 +1,140 @@
+#include <cstddef>
+#include <new>
+#include <system_error>
+#include <vector>
+#include "BatchSimulation.h"
+#include "PixelRenderer.h"
+#include "SimulationApi.h"
+
+static_assert(SIM_ENTITY_KINDS == ENTITY_KINDS, "SIM_ENTITY_KINDS must match EntityKind");
+static_assert(SIM_INPUT_RESTART == INPUT_RESTART && SIM_INPUT_START == INPUT_START && SIM_INPUT_DUCK == INPUT_DUCK &&
+                  SIM_INPUT_JUMP == INPUT_JUMP && SIM_INPUT_PAUSE == INPUT_PAUSE && SIM_INPUT_DUCK_UP == INPUT_DUCK_UP,
+              "SIM_INPUT_* must match INPUT_*");
+
+struct SimHandle
+{
+    explicit SimHandle(int threads) : workers(threads) {}
+
+    BatchState batch;
+    std::vector<GameInput> inputs;
+    BatchWorkers workers;
+    const unsigned char *actions = nullptr; // the current sim_step_batch() call's arguments
+    float *observations = nullptr;
+};
+
+static void startGames(SimHandle &sim, unsigned long long seed)
+{
+    initBatch(sim.batch, (int)sim.inputs.size(), seed);
+    for (int i = 0; i < sim.batch.count; i++)
+        sim.batch.gameState[i] = 1;
+}
+
+static void observeGame(const BatchState &batch, int i, float *out)
+{
+    float playerY = batch.playerY[i];
+    out[SIM_OBS_PLAYER_Y] = playerY;
+    out[SIM_OBS_JUMPING] = batch.isJumping[i];
+    out[SIM_OBS_DUCKING] = batch.isDucking[i];
+    out[SIM_OBS_INVINCIBLE_TIME] = batch.isInvincible[i] ? batch.powerup1ActiveTime[i] : 0;
+    out[SIM_OBS_DOUBLE_POINTS_TIME] = batch.isDoublePoints[i] ? batch.powerup2ActiveTime[i] : 0;
+    out[SIM_OBS_GAME_SPEED] = batch.gameSpeed[i];
+    out[SIM_OBS_TIME_LEFT] = batch.gameTime[i];
+    out[SIM_OBS_SCORE] = (float)batch.score[i];
+    out[SIM_OBS_LIVES] = (float)batch.lives[i];
+    out[SIM_OBS_GAME_STATE] = (float)batch.gameState[i];
+
+    // Slots are in spawn order, and a kind all moves at one speed, so they are also sorted by x
+    float *entity = out + SIM_OBS_ENTITIES;
+    for (int kind = 0; kind < ENTITY_KINDS; kind++)
+    {
+        float reach = PLAYER_SIZE / 2 + ENTITY_PARAMS[kind].size / 2;
+        int seen = 0;
+        for (int j = 0; j < batch.entityCount[kind][i] && seen < SIM_NEAREST; j++)
+        {
+            float dx = batch.entityX[kind][j * batch.count + i] - PLAYER_BASE_X;
+            if (dx <= -reach)
+                continue;
+            entity[0] = dx;
+            entity[1] = batch.entityY[kind][j * batch.count + i] - playerY;
+            entity[2] = 1;
+            entity += 3;
+            seen++;
+        }
+        for (; seen < SIM_NEAREST; seen++)
+        {
+            entity[0] = 0;
+            entity[1] = 0;
+            entity[2] = 0;
+            entity += 3;
+        }
+    }
+}
+
+static void observe(const BatchState &batch, float *observations)
+{
+    for (int i = 0; i < batch.count; i++)
+        observeGame(batch, i, observations + (size_t)i * SIM_OBSERVATION_SIZE);
+}
+
+// Actions in, one step, observations out, for one worker's share of the games
+static void stepShare(void *context, int begin, int end)
+{
+    SimHandle &sim = *(SimHandle *)context;
+    for (int i = begin; i < end; i++)
+        sim.inputs[i].keys = sim.actions[i];
+    stepBatch(sim.batch, sim.inputs.data(), begin, end);
+    for (int i = begin; i < end; i++)
+        observeGame(sim.batch, i, sim.observations + (size_t)i * SIM_OBSERVATION_SIZE);
+}
+
+SimHandle *sim_create(int count, unsigned long long seed, int threads)
+{
+    if (count <= 0)
+        return nullptr;
+    SimHandle *sim = nullptr;
+    try
+    {
+        sim = new SimHandle(threads);
+        sim->inputs.resize(count);
+        startGames(*sim, seed);
+        return sim;
+    }
+    catch (const std::bad_alloc &)
+    {
+        delete sim;
+        return nullptr;
+    }
+    catch (const std::system_error &)
+    {
+        // No threads to be had
+        delete sim;
+        return nullptr;
+    }
+}
+
+void sim_reset(SimHandle *sim, unsigned long long seed, float *observations)
+{
+    startGames(*sim, seed);
+    if (observations)
+        observe(sim->batch, observations);
+}
+
+void sim_step_batch(SimHandle *sim, const unsigned char *actions, float *observations)
+{
+    sim->actions = actions;
+    sim->observations = observations;
+    sim->workers.run(sim->batch.count, stepShare, sim);
+}
+
+int sim_render(const SimHandle *sim, unsigned char *pixels, int width, int height, int channels, int threads)
+{
+    if (width <= 0 || height <= 0 || (channels != PIXELS_GRAY && channels != PIXELS_RGB))
+        return 0;
+    renderBatch(sim->batch, pixels, width, height, (PixelFormat)channels, threads);
+    return 1;
+}
+
+void sim_destroy(SimHandle *sim)
+{
+    delete sim;
+}
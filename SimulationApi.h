@@ -0,0 +1,71 @@
+#pragma once
+
+// C interface to the batch simulator, for trainers and other languages.
+// The caller owns every array; the library reads actions from and writes observations into them directly.
+
+#ifdef _WIN32
+#ifdef SIMULATION_API_EXPORTS
+#define SIM_API __declspec(dllexport)
+#else
+#define SIM_API __declspec(dllimport)
+#endif
+#else
+#define SIM_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Action bits, one byte per game per step; same meaning as the INPUT_* flags of GameInput
+#define SIM_INPUT_RESTART 0x01
+#define SIM_INPUT_START 0x02
+#define SIM_INPUT_DUCK 0x04
+#define SIM_INPUT_JUMP 0x08
+#define SIM_INPUT_PAUSE 0x10
+#define SIM_INPUT_DUCK_UP 0x20
+
+// Each game's observation is SIM_OBSERVATION_SIZE floats, games back to back:
+// the fields below, then for each entity kind (obstacles, collectables, invincibility and double-points powerups)
+// the SIM_NEAREST nearest entities not yet past the player, as (x - player x, y - player y, present).
+// Missing entities are all zeros.
+#define SIM_OBS_PLAYER_Y 0
+#define SIM_OBS_JUMPING 1
+#define SIM_OBS_DUCKING 2
+#define SIM_OBS_INVINCIBLE_TIME 3    // seconds left, 0 when not invincible
+#define SIM_OBS_DOUBLE_POINTS_TIME 4 // seconds left, 0 when not active
+#define SIM_OBS_GAME_SPEED 5
+#define SIM_OBS_TIME_LEFT 6
+#define SIM_OBS_SCORE 7
+#define SIM_OBS_LIVES 8
+#define SIM_OBS_GAME_STATE 9 // 0: Start, 1: Playing, 2: Game Over
+#define SIM_OBS_ENTITIES 10
+
+#define SIM_ENTITY_KINDS 4
+#define SIM_NEAREST 4
+#define SIM_OBSERVATION_SIZE (SIM_OBS_ENTITIES + SIM_ENTITY_KINDS * SIM_NEAREST * 3)
+
+typedef struct SimHandle SimHandle;
+
+// `count` games, game i seeded with seed + i and already started. sim_step_batch() spreads them over
+// `threads` threads (0: one per core) that live as long as the handle. Returns null if out of memory or threads.
+SIM_API SimHandle *sim_create(int count, unsigned long long seed, int threads);
+
+// Restarts every game from a new seed and, if `observations` is not null, writes the first observations
+SIM_API void sim_reset(SimHandle *sim, unsigned long long seed, float *observations);
+
+// Steps every game once with actions[i] and writes the resulting observations; results do not depend
+// on the thread count.
+// A game that is over stays over until it gets SIM_INPUT_RESTART.
+SIM_API void sim_step_batch(SimHandle *sim, const unsigned char *actions, float *observations);
+
+// Renders every game's play screen into pixels, width * height * channels bytes per game, top row first.
+// channels is 1 (grayscale) or 3 (RGB); threads 0 uses one per core. Returns 0 on bad arguments.
+SIM_API int sim_render(const SimHandle *sim, unsigned char *pixels, int width, int height, int channels, int threads);
+
+SIM_API void sim_destroy(SimHandle *sim);
+
+#ifdef __cplusplus
+}
+#endif
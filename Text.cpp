@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <vector>
+#include "glew.h"
+#include <glut.h>
+#include "Renderer.h"
+#include "Text.h"
+
+// Printable ASCII in a 16 x 6 grid of cells. Each glyph is drawn with its origin ORIGIN_X, ORIGIN_Y
+// into its cell, which leaves room for the bitmap's offsets and descenders on every GLUT.
+const int FIRST_GLYPH = 32;
+const int GLYPH_COUNT = 95;
+const int ATLAS_COLUMNS = 16;
+const int CELL_SIZE = 32;
+const int ORIGIN_X = 6;
+const int ORIGIN_Y = 8;
+const int ATLAS_WIDTH = 512;
+const int ATLAS_HEIGHT = 256;
+
+static GLuint atlas = 0;
+static bool useAtlas = false;
+static float advances[GLYPH_COUNT];
+
+// Each glyph's set pixels within its cell, [x1, x2) x [y1, y2); empty for a space
+struct GlyphBox
+{
+    int x1, y1, x2, y2;
+};
+
+static GlyphBox boxes[GLYPH_COUNT];
+static std::vector<TextVertex> queued;
+
+static GlyphBox findGlyphBox(const std::vector<unsigned char> &pixels, int glyph)
+{
+    GlyphBox box = {CELL_SIZE, CELL_SIZE, 0, 0};
+    int cellX = glyph % ATLAS_COLUMNS * CELL_SIZE;
+    int cellY = glyph / ATLAS_COLUMNS * CELL_SIZE;
+    for (int y = 0; y < CELL_SIZE; y++)
+    {
+        for (int x = 0; x < CELL_SIZE; x++)
+        {
+            if (pixels[((cellY + y) * ATLAS_WIDTH + cellX + x) * 4 + 3])
+            {
+                box.x1 = std::min(box.x1, x);
+                box.y1 = std::min(box.y1, y);
+                box.x2 = std::max(box.x2, x + 1);
+                box.y2 = std::max(box.y2, y + 1);
+            }
+        }
+    }
+    return box;
+}
+
+bool initText()
+{
+    if (!GLEW_EXT_framebuffer_object)
+        return false;
+
+    glGenTextures(1, &atlas);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ATLAS_WIDTH, ATLAS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLuint framebuffer;
+    glGenFramebuffersEXT(1, &framebuffer);
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, framebuffer);
+    glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, atlas, 0);
+    if (glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) == GL_FRAMEBUFFER_COMPLETE_EXT)
+    {
+        glPushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT);
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        gluOrtho2D(0, ATLAS_WIDTH, 0, ATLAS_HEIGHT);
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        glLoadIdentity();
+        glViewport(0, 0, ATLAS_WIDTH, ATLAS_HEIGHT);
+
+        // White everywhere, opaque only where a glyph sets a pixel, so vertex colors tint it
+        glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+        for (int i = 0; i < GLYPH_COUNT; i++)
+        {
+            glRasterPos2i(i % ATLAS_COLUMNS * CELL_SIZE + ORIGIN_X, i / ATLAS_COLUMNS * CELL_SIZE + ORIGIN_Y);
+            glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, FIRST_GLYPH + i);
+            advances[i] = (float)glutBitmapWidth(GLUT_BITMAP_HELVETICA_18, FIRST_GLYPH + i);
+        }
+
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+        glPopAttrib();
+        useAtlas = true;
+    }
+    glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+    glDeleteFramebuffersEXT(1, &framebuffer);
+
+    // Quads only cover the glyphs' pixels, not whole cells, which is most of the fill saved
+    if (useAtlas)
+    {
+        std::vector<unsigned char> pixels(ATLAS_WIDTH * ATLAS_HEIGHT * 4);
+        glBindTexture(GL_TEXTURE_2D, atlas);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        for (int i = 0; i < GLYPH_COUNT; i++)
+            boxes[i] = findGlyphBox(pixels, i);
+    }
+    return useAtlas;
+}
+
+bool textSupported()
+{
+    return useAtlas;
+}
+
+void layoutText(TextLabel &label, float x, float y, const std::string &text, const float color[3])
+{
+    unsigned char r = (unsigned char)(color[0] * 255 + 0.5f);
+    unsigned char g = (unsigned char)(color[1] * 255 + 0.5f);
+    unsigned char b = (unsigned char)(color[2] * 255 + 0.5f);
+
+    label.vertices.clear();
+    for (char c : text)
+    {
+        int glyph = (unsigned char)c - FIRST_GLYPH;
+        if (glyph < 0 || glyph >= GLYPH_COUNT)
+            continue;
+
+        // The cell goes where its glyph's origin meets the pen
+        const GlyphBox &box = boxes[glyph];
+        float advance = advances[glyph];
+        if (box.x1 >= box.x2)
+        {
+            x += advance;
+            continue;
+        }
+        float x1 = x - ORIGIN_X + box.x1, y1 = y - ORIGIN_Y + box.y1;
+        float x2 = x - ORIGIN_X + box.x2, y2 = y - ORIGIN_Y + box.y2;
+        int cellX = glyph % ATLAS_COLUMNS * CELL_SIZE;
+        int cellY = glyph / ATLAS_COLUMNS * CELL_SIZE;
+        float u1 = float(cellX + box.x1) / ATLAS_WIDTH;
+        float v1 = float(cellY + box.y1) / ATLAS_HEIGHT;
+        float u2 = float(cellX + box.x2) / ATLAS_WIDTH;
+        float v2 = float(cellY + box.y2) / ATLAS_HEIGHT;
+        label.vertices.push_back({x1, y1, u1, v1, r, g, b, 255});
+        label.vertices.push_back({x2, y1, u2, v1, r, g, b, 255});
+        label.vertices.push_back({x2, y2, u2, v2, r, g, b, 255});
+        label.vertices.push_back({x1, y1, u1, v1, r, g, b, 255});
+        label.vertices.push_back({x2, y2, u2, v2, r, g, b, 255});
+        label.vertices.push_back({x1, y2, u1, v2, r, g, b, 255});
+        x += advance;
+    }
+    label.laidOut = true;
+}
+
+void queueText(const TextLabel &label)
+{
+    queued.insert(queued.end(), label.vertices.begin(), label.vertices.end());
+}
+
+void flushText()
+{
+    flushBatch();
+    if (queued.empty())
+        return;
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, atlas);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    // Glyph pixels are fully on or off, so the alpha test alone cuts them out
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5f);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &queued[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &queued[0].u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), &queued[0].r);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)queued.size());
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glDisable(GL_ALPHA_TEST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    queued.clear();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Text from a glyph atlas: GLUT's Helvetica 18 is drawn once into a texture, and strings become textured
+// quads that flushText() draws with one call. Glyphs land on the same pixels glutBitmapCharacter would use.
+struct TextVertex
+{
+    float x, y, u, v;
+    unsigned char r, g, b, a;
+};
+
+// Needs the GL context and initRenderer(), which loads GLEW; the atlas is drawn through a framebuffer object.
+// Returns false without one, and text then has to go through glutBitmapCharacter.
+bool initText();
+bool textSupported();
+
+// A string laid out once, to be queued frame after frame until what it shows changes
+struct TextLabel
+{
+    long long key = 0; // what the text was made from, for the caller to compare
+    bool laidOut = false;
+    std::vector<TextVertex> vertices;
+};
+
+// Lays out `text` starting at x, y, where glRasterPos would put it
+void layoutText(TextLabel &, float x, float y, const std::string &text, const float color[3]);
+
+// Adds the label to the text of this frame
+void queueText(const TextLabel &);
+
+// Draws the batch first, so the text covers it, then every queued label in one call
+void flushText();
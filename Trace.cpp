@@ -0,0 +1,110 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Profiler.h"
+#include "Trace.h"
+
+std::atomic<bool> traceEnabled(false);
+
+// The writer wakes when this many events are waiting, or every FLUSH_INTERVAL otherwise
+const size_t FLUSH_EVENTS = 4096;
+const std::chrono::milliseconds FLUSH_INTERVAL(100);
+
+struct TraceRecord
+{
+    const char *name;
+    long long start, end;
+    int thread;
+};
+
+static std::mutex traceMutex;
+static std::condition_variable traceWake;
+static std::vector<TraceRecord> pending;
+static bool stopping;
+static std::thread writer;
+static FILE *traceFile;
+static long long traceStart;
+
+static std::atomic<int> nextTraceThread(1);
+static thread_local int traceThread = 0;
+
+long long traceClock()
+{
+    return profileNow();
+}
+
+void traceEvent(const char *name, long long start, long long end)
+{
+    if (!traceThread)
+        traceThread = nextTraceThread++;
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    pending.push_back({name, start, end, traceThread});
+    if (pending.size() == FLUSH_EVENTS)
+        traceWake.notify_one();
+}
+
+// Timestamps are microseconds since startTrace()
+static void writeEvents(const std::vector<TraceRecord> &records)
+{
+    for (auto &record : records)
+    {
+        fprintf(traceFile, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", record.name,
+                record.thread, (record.start - traceStart) / 1000.0, (record.end - record.start) / 1000.0);
+    }
+}
+
+static void writeTrace()
+{
+    std::vector<TraceRecord> batch;
+    std::unique_lock<std::mutex> lock(traceMutex);
+    for (;;)
+    {
+        traceWake.wait_for(lock, FLUSH_INTERVAL, [] { return stopping || pending.size() >= FLUSH_EVENTS; });
+        batch.swap(pending);
+        bool last = stopping;
+        lock.unlock();
+
+        writeEvents(batch);
+        batch.clear();
+        if (last)
+            return;
+        lock.lock();
+    }
+}
+
+bool startTrace(const char *path)
+{
+    traceFile = fopen(path, "w");
+    if (!traceFile)
+        return false;
+
+    // The metadata event opens the array, so every real event can start with a comma
+    fprintf(traceFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                       "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"2DPlat\"}}");
+    traceStart = profileNow();
+    stopping = false;
+    writer = std::thread(writeTrace);
+    traceEnabled = true;
+    return true;
+}
+
+void stopTrace()
+{
+    if (!traceFile)
+        return;
+    traceEnabled = false;
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        stopping = true;
+    }
+    traceWake.notify_one();
+    writer.join();
+
+    fprintf(traceFile, "\n]}\n");
+    fclose(traceFile);
+    traceFile = nullptr;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <atomic>
+
+// Chrome trace-event output (chrome://tracing, ui.perfetto.dev): every traced scope becomes a
+// complete event on its thread's track. Events are buffered and written by a background thread.
+extern std::atomic<bool> traceEnabled;
+
+// Opens `path` and starts the writer; returns false if the file cannot be created
+bool startTrace(const char *path);
+
+// Writes out everything still buffered and closes the file
+void stopTrace();
+
+long long traceClock();
+
+// Adds an event that ran from start to end, in profileNow() nanoseconds
+void traceEvent(const char *name, long long start, long long end);
+
+// Traces the enclosing block; `name` must outlive the trace, a string literal in practice.
+// When tracing is off this costs the one branch in the constructor and the matching one in the destructor.
+struct TraceScope
+{
+    const char *name;
+    long long start;
+
+    TraceScope(const char *name) : name(name), start(traceEnabled.load(std::memory_order_relaxed) ? traceClock() : 0) {}
+    ~TraceScope()
+    {
+        if (start)
+            traceEvent(name, start, traceClock());
+    }
+};
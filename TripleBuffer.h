@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+
+// Hands whole values from one writer thread to one reader thread without locks or waiting.
+// The writer fills back(), then publish() swaps it with the spare slot; the reader's take() swaps
+// the spare with its front() slot if something new was published. Neither side ever touches a slot
+// the other holds, so the reader always sees a complete value, the newest one as of its last take().
+template <typename T>
+struct TripleBuffer
+{
+    // Bits of `spare`: the slot index, and whether it holds a value the reader has not taken
+    static const int INDEX = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    int backIndex = 0;  // writer's
+    int frontIndex = 1; // reader's
+    std::atomic<int> spare{2};
+
+    T &back() { return slots[backIndex]; }
+    void publish() { backIndex = spare.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    const T &front() const { return slots[frontIndex]; }
+
+    // Returns false, keeping the same front(), if nothing was published since the last take()
+    bool take()
+    {
+        if (!(spare.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        frontIndex = spare.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+};